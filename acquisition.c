@@ -0,0 +1,210 @@
+/** ****************************************************************
+ * @file acquisition.c
+ * @brief Asynchronous IR sensor acquisition for Khepera IV.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * A dedicated thread polls the dsPic proximity sensors at its own rate and
+ * publishes timestamped frames through a seqlock, so the model reads the
+ * newest frame without waiting on the I2C bus. Frames are copied with the
+ * relaxed atomic words of snapshot.c.
+ * In simulation there is no thread, frames are read when the model asks
+ * for them, at the virtual time of the tick.
+***************************************************************** */
+#include "acquisition.h"
+#include "scheduler.h"
+#include "probe.h"
+#include "rt.h"
+#include "bus.h"
+#include "snapshot.h"
+#include <stdio.h>
+#include <string.h>
+
+/** ****************************************************************
+ * Read one IR frame from dsPic
+ *
+ * @param a acquisition state
+ * @param f frame to fill, ultrasound values are kept when they are not read
+ * @brief function that read and unpack the proximity and ground sensors, and ultrasounds and battery on their frames
+ * @return 0 if ok, -1 if error
+ * @note ultrasounds are read on the middle frame of each us_div frames, so
+ * they never come with the first reading
+***************************************************************** */
+static int read_frame(acquisition_t *a, ir_frame_t *f){
+	unsigned char Buffer[256];
+	int i, ret;
+	ret = bus_proximity_ir(a->dev, (char *)Buffer);
+	if(ret < 0)
+		return -1;
+	f->t_ns = hal_now_ns(a->dev);
+	for(i=0; i<IR_CHANNELS; i++)
+		f->ir[i] = (uint16_t)(Buffer[i*2] | Buffer[i*2+1]<<8);
+	for(i=0; i<GROUND_CHANNELS; i++)
+		f->ground[i] = (uint16_t)(Buffer[(IR_CHANNELS+i)*2] | Buffer[(IR_CHANNELS+i)*2+1]<<8);
+	if(a->us_div > 0 && a->frames % a->us_div == (uint32_t)a->us_div/2){
+		ret = bus_measure_us(a->dev, (char *)Buffer);
+		if(ret >= 0){
+			for(i=0; i<HAL_US_CHANNELS; i++)
+				f->us[i] = (uint16_t)(Buffer[i*2] | Buffer[i*2+1]<<8);
+			f->us_t_ns = hal_now_ns(a->dev);
+			a->us_reads++;
+		}
+	}
+	if(a->frames % ACQ_BATTERY_DIV == 0 && bus_battery_status(a->dev, (char *)Buffer) >= 0){
+		f->battery = Buffer[3];
+		f->current = (int16_t)((int16_t)(Buffer[4] | Buffer[5]<<8)*0.07813);
+		a->battery_reads++;
+	}
+	a->frames++;
+	return 0;
+}
+
+/** ****************************************************************
+ * Publish a frame
+ *
+ * @param a acquisition state
+ * @param f frame to publish
+ * @brief function that publish a frame through the seqlock (writer side)
+ * @return 0 when ok
+***************************************************************** */
+static int publish_frame(acquisition_t *a, const ir_frame_t *f){
+	uint32_t seq = __atomic_load_n(&a->seqlock, __ATOMIC_RELAXED);
+	ir_frame_t frame = *f;
+	frame.seq = (seq+2)/2;
+	__atomic_store_n(&a->seqlock, seq+1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	snapshot_store_words(&a->frame, &frame, sizeof(frame)); // relaxed atomic words, as snapshot.c
+	__atomic_store_n(&a->seqlock, seq+2, __ATOMIC_RELEASE);
+	return 0;
+}
+
+/** ****************************************************************
+ * Acquisition thread
+ *
+ * @param args acquisition state
+ * @brief thread that poll the proximity sensors at acquisition period
+***************************************************************** */
+static void* acquisition_thread(void *args){
+	acquisition_t *a = (acquisition_t *)args;
+	scheduler_t sched;
+	rt_thread(RT_ACQUISITION);
+	scheduler_init(&sched, a->period_us, a->dev);
+	while(__atomic_load_n(&a->running, __ATOMIC_ACQUIRE)){
+		if(__atomic_load_n(&a->period_us, __ATOMIC_RELAXED) != sched.period_us)
+			scheduler_set_period(&sched, __atomic_load_n(&a->period_us, __ATOMIC_RELAXED));
+		if(read_frame(a, &a->work) == 0)
+			publish_frame(a, &a->work);
+		else
+			a->read_errors++;
+		scheduler_wait(&sched);
+	}
+	return NULL;
+}
+
+/** ****************************************************************
+ * Start acquisition
+ *
+ * @param a acquisition state
+ * @param dev robot device
+ * @param period_us acquisition period (in us)
+ * @param us_div ultrasounds are read every us_div frames, 0 to never read them
+ * @brief function that read a first frame and start acquisition thread
+ * @return 0 if ok, -1 if error
+ * @note a frame is always available when this function returns
+ * @note no thread is started in simulation, see acquisition_latest()
+***************************************************************** */
+int acquisition_start(acquisition_t *a, hal_dev_t *dev, long period_us, int us_div){
+	int i;
+	memset(a, 0, sizeof(*a));
+	a->dev = dev;
+	a->period_us = period_us;
+	a->us_div = us_div;
+	a->sync = hal_is_simulated();
+	for(i=0; i<HAL_US_CHANNELS; i++)
+		a->work.us[i] = ACQ_US_NONE;
+	a->work.battery = -1;
+	if(read_frame(a, &a->work) < 0){
+		printf("ERROR: could not read proximity sensors\n");
+		return -1;
+	}
+	publish_frame(a, &a->work);
+	if(a->sync)
+		return 0;
+	a->running = 1;
+	if(pthread_create(&a->thread, NULL, &acquisition_thread, a) != 0){
+		printf("ERROR: could not create acquisition thread\n");
+		a->running = 0;
+		return -1;
+	}
+	return 0;
+}
+
+/** ****************************************************************
+ * Stop acquisition
+ *
+ * @param a acquisition state
+ * @brief function that stop and join acquisition thread
+ * @return 0 when ok
+***************************************************************** */
+int acquisition_stop(acquisition_t *a){
+	if(a->running){
+		__atomic_store_n(&a->running, 0, __ATOMIC_RELEASE);
+		pthread_join(a->thread, NULL);
+	}
+	if(a->read_errors)
+		printf("Acquisition: %lu failed readings\n", a->read_errors);
+	return 0;
+}
+
+/** ****************************************************************
+ * Inject a frame
+ *
+ * @param a acquisition state, not started
+ * @param f frame to publish
+ * @brief function that publish a frame given by the caller instead of the robot (replay)
+ * @return 0 when ok
+***************************************************************** */
+int acquisition_inject(acquisition_t *a, const ir_frame_t *f){
+	a->frames++;
+	return publish_frame(a, f);
+}
+
+/** ****************************************************************
+ * Change acquisition period
+ *
+ * @param a acquisition state
+ * @param period_us new acquisition period (in us)
+ * @brief function that change the polling period, taken by the acquisition thread on its next frame
+ * @return 0 when ok
+***************************************************************** */
+int acquisition_set_period(acquisition_t *a, long period_us){
+	__atomic_store_n(&a->period_us, period_us, __ATOMIC_RELAXED);
+	return 0;
+}
+
+/** ****************************************************************
+ * Get latest frame
+ *
+ * @param a acquisition state
+ * @param out frame copy
+ * @brief function that copy the newest published frame (reader side), never block
+ * @return 0 when ok
+ * @note in simulation a new frame is read first
+***************************************************************** */
+int acquisition_latest(acquisition_t *a, ir_frame_t *out){
+	uint32_t s1, s2;
+	if(a->sync){
+		if(read_frame(a, &a->work) == 0)
+			publish_frame(a, &a->work);
+		else
+			a->read_errors++;
+	}
+	do{
+		s1 = __atomic_load_n(&a->seqlock, __ATOMIC_ACQUIRE);
+		snapshot_load_words(out, &a->frame, sizeof(*out)); // a torn copy is discarded
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		s2 = __atomic_load_n(&a->seqlock, __ATOMIC_RELAXED);
+	}while((s1 & 1) || (s1 != s2));
+	return 0;
+}
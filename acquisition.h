@@ -0,0 +1,75 @@
+/** ****************************************************************
+ * @file acquisition.h
+ * @brief Asynchronous IR sensor acquisition for Khepera IV.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * A dedicated thread polls the dsPic proximity sensors at its own rate and
+ * publishes timestamped frames through a seqlock, so the model reads the
+ * newest frame without waiting on the I2C bus. Ground sensors come with
+ * the same transaction, ultrasounds are read every few frames.
+ * In simulation there is no thread, frames are read when the model asks
+ * for them, at the virtual time of the tick.
+***************************************************************** */
+#ifndef ACQUISITION_H
+#define ACQUISITION_H
+
+#include "hal.h"
+#include <pthread.h>
+#include <stdint.h>
+
+#define IR_CHANNELS 8 ///< number of proximity channels used by the model
+#define GROUND_CHANNELS 4 ///< number of ground channels, after proximity channels in dsPic buffer
+#define ACQ_PERIOD 20000 ///< default acquisition period (in us)
+#define ACQ_US_DIV 5 ///< ultrasounds are read every ACQ_US_DIV frames when enabled
+#define ACQ_US_NONE 1000 ///< ultrasound value when nothing is detected or not read yet
+#define ACQ_BATTERY_DIV 50 ///< battery is read every ACQ_BATTERY_DIV frames
+
+/** ****************************************************************
+ * IR frame
+ *
+ * @brief fused perception frame, raw proximity and ground values read in a
+ * single dsPic transaction and last ultrasound values
+ * @note size is a multiple of 4 bytes, the seqlock copies it by words (see snapshot.c)
+***************************************************************** */
+typedef struct {
+	uint64_t t_ns; ///< monotonic time of the reading (in ns)
+	uint32_t seq; ///< frame number, incremented for each published frame
+	uint16_t ir[IR_CHANNELS]; ///< raw proximity values
+	uint16_t ground[GROUND_CHANNELS]; ///< raw ground values
+	uint16_t us[HAL_US_CHANNELS]; ///< last ultrasound values (in cm), ACQ_US_NONE if not read
+	uint64_t us_t_ns; ///< monotonic time of the ultrasound reading (in ns), 0 if never read
+	int16_t battery; ///< last battery charge (in %), -1 if not read yet
+	int16_t current; ///< last battery current (in mA)
+} ir_frame_t;
+
+/** ****************************************************************
+ * Acquisition state
+ *
+ * @brief state shared between acquisition thread and model
+ * @note single producer (acquisition thread), single consumer (model)
+***************************************************************** */
+typedef struct {
+	hal_dev_t *dev; ///< robot device
+	long period_us; ///< acquisition period (in us), changed by acquisition_set_period() while running
+	int sync; ///< 1 when frames are read by the model instead of a thread (simulation)
+	pthread_t thread; ///< acquisition thread
+	int running; ///< 1 while acquisition thread must run
+	int us_div; ///< ultrasounds are read every us_div frames, 0 to never read them
+	uint32_t frames; ///< number of readings done
+	ir_frame_t work; ///< frame being read (writer side), keeps last ultrasound values
+	uint32_t seqlock; ///< sequence counter, odd while a frame is written
+	ir_frame_t frame; ///< last published frame
+	unsigned long read_errors; ///< number of failed dsPic readings
+	unsigned long us_reads; ///< number of ultrasound readings
+	unsigned long battery_reads; ///< number of battery readings
+} acquisition_t;
+
+int acquisition_start(acquisition_t *a, hal_dev_t *dev, long period_us, int us_div);
+int acquisition_stop(acquisition_t *a);
+int acquisition_latest(acquisition_t *a, ir_frame_t *out);
+int acquisition_inject(acquisition_t *a, const ir_frame_t *f);
+int acquisition_set_period(acquisition_t *a, long period_us);
+
+#endif
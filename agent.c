@@ -0,0 +1,328 @@
+/** ****************************************************************
+ * @file agent.c
+ * @brief On-robot agent of the fleet coordinator.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * Events are queued by the model in a preallocated ring and sent by a
+ * background thread, which also answers clock probes while the model
+ * runs, so the model loop never waits on the network.
+***************************************************************** */
+#include "agent.h"
+#include "rt.h"
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+/** ****************************************************************
+ * Agent state
+ *
+ * @brief event ring shared by the model (producer) and the agent thread (consumer)
+***************************************************************** */
+static struct {
+	fleet_msg_t ring[AGENT_RING]; ///< preallocated events
+	uint32_t head; ///< next event to queue, written by the model
+	uint32_t tail; ///< next event to send, written by the agent thread
+	int sock; ///< connection to coordinator
+	const model_t *model; ///< running model, its state is read through its snapshot
+	uint64_t start_ns; ///< model start time on robot clock, first status is one period later
+	pthread_t thread; ///< agent thread
+	int running; ///< 1 while agent thread must run
+	unsigned long dropped; ///< events dropped because ring was full
+} agent;
+
+/** ****************************************************************
+ * Send a message
+ *
+ * @param msg message to send, size bytes
+ * @brief function that send a whole message to coordinator
+ * @return 0 when ok, -1 if error
+***************************************************************** */
+static int agent_send(const void *msg, size_t size){
+	const char *p = msg;
+	ssize_t n;
+	while(size > 0){
+		n = send(agent.sock, p, size, MSG_NOSIGNAL);
+		if(n < 0 && errno == EINTR)
+			continue;
+		if(n <= 0)
+			return -1;
+		p += n;
+		size -= n;
+	}
+	return 0;
+}
+
+/** ****************************************************************
+ * Receive bytes
+ *
+ * @param buf buffer to fill
+ * @param size number of bytes to receive
+ * @brief function that receive exactly size bytes from coordinator
+ * @return 0 when ok, -1 if error or connection closed
+***************************************************************** */
+static int agent_recv(void *buf, size_t size){
+	char *p = buf;
+	ssize_t n;
+	while(size > 0){
+		n = recv(agent.sock, p, size, 0);
+		if(n < 0 && errno == EINTR)
+			continue;
+		if(n <= 0)
+			return -1;
+		p += n;
+		size -= n;
+	}
+	return 0;
+}
+
+/** ****************************************************************
+ * Answer a clock probe
+ *
+ * @param msg clock probe, t2_ns already set to its receive time
+ * @brief function that send back the probe with robot send time
+ * @return 0 when ok, -1 if error
+***************************************************************** */
+static int agent_sync(fleet_msg_t *msg){
+	msg->t3_ns = hal_now_ns(NULL);
+	return agent_send(msg, sizeof(*msg));
+}
+
+/** ****************************************************************
+ * Send a status
+ *
+ * @brief function that send the last published model state, read without lock
+ * @return 0 when ok, -1 if error
+***************************************************************** */
+static int agent_status(void){
+	fleet_msg_t msg;
+	snapshot_t s;
+	float low;
+	int i;
+	if(snapshot_read(&agent.model->state, &s) < 0)
+		return -1;
+	low = s.var[0];
+	for(i=1; i<NEED_COUNT; i++)
+		if(s.var[i] < low)
+			low = s.var[i];
+	memset(&msg, 0, sizeof(msg));
+	msg.type = FLEET_STATUS;
+	msg.size = sizeof(msg);
+	msg.tick = s.tick;
+	msg.t_ns = hal_now_ns(NULL);
+	msg.a = s.behaviour;
+	msg.b = (int32_t)(low*1000000.0f);
+	return agent_send(&msg, sizeof(msg));
+}
+
+/** ****************************************************************
+ * Agent thread
+ *
+ * @param args unused
+ * @brief thread that answer clock probes, send queued events and status
+***************************************************************** */
+static void* agent_thread(void *args){
+	struct pollfd pfd;
+	fleet_msg_t msg;
+	uint32_t h, t;
+	uint64_t next_status_ns = agent.start_ns + AGENT_STATUS*1000000ULL;
+	int run = 1;
+	rt_thread(RT_BACKGROUND);
+	pfd.fd = agent.sock;
+	pfd.events = POLLIN;
+	while(run){
+		run = __atomic_load_n(&agent.running, __ATOMIC_ACQUIRE);
+		if(run && poll(&pfd, 1, AGENT_POLL) > 0){
+			if(agent_recv(&msg, sizeof(msg)) < 0)
+				pfd.fd = -1; // coordinator left, events are still consumed
+			else if(msg.type == FLEET_SYNC){
+				msg.t2_ns = hal_now_ns(NULL);
+				agent_sync(&msg);
+			}
+		}
+		h = __atomic_load_n(&agent.head, __ATOMIC_ACQUIRE);
+		for(t=agent.tail; t!=h; t++)
+			if(pfd.fd >= 0)
+				agent_send(&agent.ring[t & (AGENT_RING-1)], sizeof(fleet_msg_t));
+		__atomic_store_n(&agent.tail, t, __ATOMIC_RELEASE);
+		if(pfd.fd >= 0 && hal_now_ns(NULL) >= next_status_ns){
+			agent_status();
+			next_status_ns += AGENT_STATUS*1000000ULL;
+		}
+	}
+	return NULL;
+}
+
+/** ****************************************************************
+ * Report an event
+ *
+ * @param m model context
+ * @param type event type (FLEET_SWITCH, FLEET_DAMAGE...)
+ * @param a first argument
+ * @param b second argument
+ * @brief function that queue an event stamped with robot clock, never block
+ * @return 0 when ok, -1 if ring is full
+***************************************************************** */
+int agent_event(model_t *m, int type, int a, int b){
+	uint32_t h = agent.head;
+	fleet_msg_t *e;
+	if(h - __atomic_load_n(&agent.tail, __ATOMIC_ACQUIRE) >= AGENT_RING){
+		agent.dropped++;
+		return -1;
+	}
+	e = &agent.ring[h & (AGENT_RING-1)];
+	memset(e, 0, sizeof(*e));
+	e->type = type;
+	e->size = sizeof(*e);
+	e->tick = m->tick;
+	e->t_ns = hal_now_ns(NULL);
+	e->a = a;
+	e->b = b;
+	__atomic_store_n(&agent.head, h+1, __ATOMIC_RELEASE);
+	return 0;
+}
+
+/** ****************************************************************
+ * Wait for coordinator
+ *
+ * @param port TCP port to listen
+ * @brief function that accept the connection of the coordinator
+ * @return 0 when ok, -1 if error
+***************************************************************** */
+static int agent_accept(int port){
+	struct sockaddr_in addr;
+	int s, one = 1;
+	s = socket(AF_INET, SOCK_STREAM, 0);
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons(port);
+	if(s < 0 || setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) < 0
+		|| bind(s, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(s, 1) < 0){
+		printf("ERROR: could not listen on port %d\n", port);
+		if(s >= 0)
+			close(s);
+		return -1;
+	}
+	printf("Agent: waiting for coordinator on port %d\n", port);
+	agent.sock = accept(s, NULL, NULL);
+	close(s);
+	if(agent.sock < 0){
+		printf("ERROR: could not accept coordinator\n");
+		return -1;
+	}
+	setsockopt(agent.sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	return 0;
+}
+
+/** ****************************************************************
+ * Apply pushed options
+ *
+ * @param m model context
+ * @param msg FLEET_CONFIG header, payload is read here
+ * @brief function that parse NUL separated model options of coordinator
+ * @return 0 when ok, -1 if error
+ * @note empty options are skipped, a config with more options than argv holds is rejected
+***************************************************************** */
+static int agent_config(model_t *m, const fleet_msg_t *msg){
+	static char args[FLEET_ARGS+1]; // options keep pointers to telemetry file names
+	char *argv[FLEET_ARGS/2+1];
+	size_t size = msg->size - sizeof(*msg), i;
+	int argc = 0;
+	if(msg->size < sizeof(*msg) || size > FLEET_ARGS){
+		printf("ERROR: invalid fleet config of %d bytes\n", msg->size);
+		return -1;
+	}
+	if(agent_recv(args, size) < 0)
+		return -1;
+	args[size] = '\0';
+	for(i=0; i<size; i+=strlen(&args[i])+1){
+		if(args[i] == '\0')
+			continue;
+		if(argc == (int)(sizeof(argv)/sizeof(argv[0]))){
+			printf("ERROR: fleet config has more than %d options\n", argc);
+			return -1;
+		}
+		argv[argc++] = &args[i];
+	}
+	return model_options(m, argc, argv);
+}
+
+/** ****************************************************************
+ * Set agent thread class
+ *
+ * @param cls thread class (see rt.h)
+ * @brief function that set scheduling class of the agent thread, started before real-time mode
+ * @return 0 when ok, -1 if error
+***************************************************************** */
+int agent_thread_class(int cls){
+	if(!agent.running)
+		return 0;
+	return rt_set(agent.thread, cls);
+}
+
+/** ****************************************************************
+ * Run agent
+ *
+ * @param m model context, initialised
+ * @param port TCP port to listen
+ * @brief function that wait for the coordinator, run the model when asked and report its events
+ * @return 0 when ok, -1 if error
+ * @note agent serves a single experiment, then returns
+***************************************************************** */
+int agent_main(model_t *m, int port){
+	fleet_msg_t msg;
+	int r;
+	if(agent_accept(port) < 0)
+		return -1;
+	memset(&msg, 0, sizeof(msg));
+	msg.type = FLEET_HELLO;
+	msg.size = sizeof(msg);
+	msg.t_ns = hal_now_ns(NULL);
+	msg.a = FLEET_VERSION;
+	agent_send(&msg, sizeof(msg));
+	for(;;){
+		if(agent_recv(&msg, sizeof(msg)) < 0){
+			printf("ERROR: coordinator left before start\n");
+			close(agent.sock);
+			return -1;
+		}
+		if(msg.type == FLEET_SYNC){
+			msg.t2_ns = hal_now_ns(NULL);
+			agent_sync(&msg);
+		}
+		else if(msg.type == FLEET_CONFIG && agent_config(m, &msg) < 0){
+			close(agent.sock);
+			return -1;
+		}
+		else if(msg.type == FLEET_START)
+			break;
+	}
+	agent.head = 0;
+	agent.tail = 0;
+	agent.dropped = 0;
+	agent.model = m;
+	agent.start_ns = msg.t2_ns;
+	agent.running = 1;
+	if(pthread_create(&agent.thread, NULL, &agent_thread, NULL) != 0){
+		printf("ERROR: could not create agent thread\n");
+		close(agent.sock);
+		return -1;
+	}
+	hal_sleep_until(NULL, msg.t2_ns);
+	m->fleet = 1;
+	agent_event(m, FLEET_STARTED, 0, 0);
+	r = model(m); // death is reported by model loop
+	__atomic_store_n(&agent.running, 0, __ATOMIC_RELEASE);
+	pthread_join(agent.thread, NULL);
+	close(agent.sock);
+	printf("Agent: %lu events dropped\n", agent.dropped);
+	return r;
+}
@@ -0,0 +1,26 @@
+/** ****************************************************************
+ * @file agent.h
+ * @brief On-robot agent of the fleet coordinator.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * The agent waits for the coordinator, answers clock probes, applies the
+ * pushed model options, starts the model at the requested instant and
+ * reports its events and a periodic status (see fleet.h for the protocol).
+***************************************************************** */
+#ifndef AGENT_H
+#define AGENT_H
+
+#include "model.h"
+#include "fleet.h"
+
+#define AGENT_RING 256 ///< number of events queued for the coordinator (power of 2)
+#define AGENT_POLL 50 ///< period of agent thread when no probe is received (in ms)
+#define AGENT_STATUS 1000 ///< period of status reports (in ms)
+
+int agent_main(model_t *m, int port);
+int agent_event(model_t *m, int type, int a, int b);
+int agent_thread_class(int cls);
+
+#endif
@@ -0,0 +1,475 @@
+/** ****************************************************************
+ * @file bench.c
+ * @brief Micro-benchmarks of the per-tick kernels of the model.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * Frame dependent state (preprocessing results, speeds, history) is
+ * computed once per frame by a model context, then loaded before each
+ * kernel call. The time of the same loop with only the loads is measured
+ * and subtracted, so results are the cost of the kernel alone. Cycles are
+ * read from the perf cycle counter when the kernel allows it.
+***************************************************************** */
+#include "bench.h"
+#include "model.h"
+#include "telemetry.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define BENCH_SIMD "neon" ///< SIMD variant of preprocessing and Braitenberg kernels
+#else
+#define BENCH_SIMD "scalar" ///< SIMD variant of preprocessing and Braitenberg kernels
+#endif
+
+#ifdef MODEL_PROBES
+#define BENCH_PROBES 1 ///< 1 when hot-path probes are built in, they time update_vars() stages
+#else
+#define BENCH_PROBES 0 ///< 1 when hot-path probes are built in, they time update_vars() stages
+#endif
+
+/** ****************************************************************
+ * Benchmark frame
+ *
+ * @brief raw frame and model state derived from it
+***************************************************************** */
+typedef struct {
+	ir_frame_t frame; ///< raw frame
+	preprocess_t pre; ///< preprocessing results of the frame
+	float speed[8]; ///< sensor speeds of the frame
+	float circ_speed[7]; ///< circular speeds before circ_damage()
+	int circ_active; ///< circular detector state before circ_damage()
+	unsigned int ir_moving; ///< sensors moving over the stats window of the frame
+	history_t history; ///< sensor history of the frame, read by speed_damage()
+} bench_frame_t;
+
+/** ****************************************************************
+ * Benchmark kernel
+ *
+ * @brief kernel called once per operation, after its load function
+***************************************************************** */
+typedef struct {
+	const char *name; ///< kernel name in results
+	int (*load)(model_t *m, const bench_frame_t *f); ///< state setup of a call, timed apart and subtracted, NULL if none
+	int (*run)(model_t *m, const bench_frame_t *f); ///< kernel call
+} bench_kernel_t;
+
+static volatile int bench_sink; ///< kernel results, kept so calls are not optimized out
+
+/** ****************************************************************
+ * Load frame state
+ *
+ * @param m model context
+ * @param f benchmark frame
+ * @brief function that load the state computed by get_sensors() for the frame
+ * @return 0 when ok
+***************************************************************** */
+static int bench_load_state(model_t *m, const bench_frame_t *f){
+	m->pre = f->pre;
+	memcpy(m->speed, f->speed, sizeof(m->speed));
+	memcpy(m->circ_speed, f->circ_speed, sizeof(m->circ_speed));
+	m->circ_active = f->circ_active;
+	m->ir_moving = f->ir_moving;
+	memcpy(&m->history, &f->history, sizeof(m->history));
+	return 0;
+}
+
+/** ****************************************************************
+ * Load raw frame
+ *
+ * @param m model context
+ * @param f benchmark frame
+ * @brief function that publish the raw frame as acquisition would
+ * @return 0 when ok
+***************************************************************** */
+static int bench_load_frame(model_t *m, const bench_frame_t *f){
+	return acquisition_inject(&m->acquisition, &f->frame);
+}
+
+/** ****************************************************************
+ * Sensors kernel
+ *
+ * @param m model context
+ * @param f benchmark frame
+ * @brief function that run get_sensors() on the published frame and commit it in history
+ * @return 0 when ok
+***************************************************************** */
+static int bench_get_sensors(model_t *m, const bench_frame_t *f){
+	get_sensors(m);
+	return get_sensors_history(m);
+}
+
+/** ****************************************************************
+ * Speed damage kernel
+ *
+ * @param m model context
+ * @param f benchmark frame
+ * @brief function that run speed_damage() on the loaded frame state
+ * @return result of speed_damage()
+***************************************************************** */
+static int bench_speed_damage(model_t *m, const bench_frame_t *f){
+	return bench_sink = speed_damage(m);
+}
+
+/** ****************************************************************
+ * Circular damage kernel
+ *
+ * @param m model context
+ * @param f benchmark frame
+ * @brief function that run circ_damage() on the loaded frame state
+ * @return 0 when ok
+***************************************************************** */
+static int bench_circ_damage(model_t *m, const bench_frame_t *f){
+	return circ_damage(m);
+}
+
+/** ****************************************************************
+ * Cues kernel
+ *
+ * @param m model context
+ * @param f benchmark frame
+ * @brief function that compute every cue on the loaded frame state
+ * @return 0 when ok
+***************************************************************** */
+static int bench_compute_cues(model_t *m, const bench_frame_t *f){
+	m->cue_dirty = NEED_ALL; // every cue is computed
+	return compute_cues(m);
+}
+
+/** ****************************************************************
+ * Motivations kernel
+ *
+ * @param m model context
+ * @param f benchmark frame
+ * @brief function that compute every deficit and motivation
+ * @return 0 when ok
+***************************************************************** */
+static int bench_motivations(model_t *m, const bench_frame_t *f){
+	m->var_dirty = NEED_ALL; // every deficit and motivation is computed
+	compute_deficit(m);
+	return compute_motivations(m);
+}
+
+/** ****************************************************************
+ * Selection kernel
+ *
+ * @param m model context
+ * @param f benchmark frame
+ * @brief function that select the behavioral group of the motivations
+ * @return selected need
+***************************************************************** */
+static int bench_winner_takes_all(model_t *m, const bench_frame_t *f){
+	return bench_sink = winner_takes_all(m->mot, NEED_COUNT);
+}
+
+/** ****************************************************************
+ * Tick kernel
+ *
+ * @param m model context
+ * @param f benchmark frame
+ * @brief function that run the sensor, damage and variable stages of a tick on the published frame
+ * @return 0 when ok
+***************************************************************** */
+static int bench_update_vars(model_t *m, const bench_frame_t *f){
+	update_vars(m, 1);
+	return get_sensors_history(m);
+}
+
+static const bench_kernel_t kernels[] = {
+	{"get_sensors", bench_load_frame, bench_get_sensors},
+	{"speed_damage", bench_load_state, bench_speed_damage},
+	{"circ_damage", bench_load_state, bench_circ_damage},
+	{"compute_cues", bench_load_state, bench_compute_cues},
+	{"motivations", NULL, bench_motivations},
+	{"winner_takes_all", NULL, bench_winner_takes_all},
+	{"update_vars", bench_load_frame, bench_update_vars}
+}; ///< benchmarked kernels, in tick order
+
+/** ****************************************************************
+ * Synthetic frames
+ *
+ * @param f frames to fill
+ * @param n number of frames
+ * @brief function that generate idle, approaching, scratching and noisy frames, 32 frames each in turn
+ * @return n
+ * @note frames are the same on every run, so results of several builds can be compared
+***************************************************************** */
+static int bench_synthetic(bench_frame_t *f, int n){
+	uint32_t x = 12345;
+	int k, i, v;
+	memset(f, 0, n*sizeof(*f));
+	for(k=0; k<n; k++){
+		for(i=0; i<IR_CHANNELS; i++){
+			x = x*1664525u + 1013904223u;
+			switch((k/32) & 3){
+				case 0: v = 100 + (x >> 28); break; // idle, noise below speed threshold
+				case 1: v = (i == 3) ? 100 + (k & 31)*15 : 100; break; // obstacle approaching front sensor
+				case 2: v = 600 + (x >> 25); break; // sensors all near, scratching
+				default: v = x >> 22; break; // noise over the whole range
+			}
+			f[k].frame.ir[i] = v;
+		}
+		f[k].frame.seq = k;
+		f[k].frame.t_ns = (uint64_t)k*TIME*1000; // one frame per default tick, for history velocities
+	}
+	return n;
+}
+
+/** ****************************************************************
+ * Recorded frames
+ *
+ * @param f frames to fill
+ * @param n number of frames
+ * @param path telemetry file
+ * @brief function that read the raw frames of the first n ticks of a telemetry file
+ * @return number of frames read, -1 if error
+***************************************************************** */
+static int bench_recorded(bench_frame_t *f, int n, const char *path){
+	telemetry_header_t header;
+	telemetry_record_t r;
+	FILE *in = fopen(path, "rb");
+	int k = 0, i;
+	if(in == NULL || fread(&header, sizeof(header), 1, in) != 1 || header.magic != TELEMETRY_MAGIC
+		|| header.version != TELEMETRY_VERSION || header.record_size != sizeof(r)){
+		printf("ERROR: %s is not a telemetry file of version %d\n", path, TELEMETRY_VERSION);
+		if(in != NULL)
+			fclose(in);
+		return -1;
+	}
+	memset(f, 0, n*sizeof(*f));
+	while(k < n && fread(&r, sizeof(r), 1, in) == 1){
+		if(r.tick == 0)
+			continue; // priming frames
+		f[k].frame.t_ns = r.t_ns;
+		f[k].frame.seq = k;
+		for(i=0; i<IR_CHANNELS; i++)
+			f[k].frame.ir[i] = r.ir[i];
+		for(i=0; i<GROUND_CHANNELS; i++)
+			f[k].frame.ground[i] = r.ground[i];
+		for(i=0; i<HAL_US_CHANNELS; i++)
+			f[k].frame.us[i] = r.us[i];
+		k++;
+	}
+	fclose(in);
+	if(k == 0){
+		printf("ERROR: no recorded tick in %s\n", path);
+		return -1;
+	}
+	for(i=k; i<n; i++)
+		f[i].frame = f[i % k].frame; // short files are repeated
+	return k;
+}
+
+/** ****************************************************************
+ * Reset model context
+ *
+ * @param m model context
+ * @brief function that init a model context without robot for benchmarks
+ * @return 0 when ok, -1 if error
+***************************************************************** */
+static int bench_reset(model_t *m){
+	model_init(m, NULL);
+	return stats_init(&m->ir_stats, m->cue_alpha);
+}
+
+/** ****************************************************************
+ * Compute frame states
+ *
+ * @param m model context
+ * @param f frames
+ * @param n number of frames
+ * @brief function that run the sensor and damage stages of a model on the frames, storing their state
+ * @return 0 when ok
+***************************************************************** */
+static int bench_prepare(model_t *m, bench_frame_t *f, int n){
+	int k;
+	bench_reset(m);
+	for(k=0; k<n; k++){
+		acquisition_inject(&m->acquisition, &f[k].frame);
+		get_sensors(m);
+		f[k].pre = m->pre;
+		memcpy(f[k].speed, m->speed, sizeof(f[k].speed));
+		memcpy(f[k].circ_speed, m->circ_speed, sizeof(f[k].circ_speed));
+		f[k].circ_active = m->circ_active;
+		f[k].ir_moving = m->ir_moving;
+		memcpy(&f[k].history, &m->history, sizeof(f[k].history));
+		check_if_damage(m);
+		apply_damage(m);
+		get_sensors_history(m);
+	}
+	return 0;
+}
+
+/** ****************************************************************
+ * Open cycle counter
+ *
+ * @brief function that open the perf cycle counter of the calling thread, user space only
+ * @return counter file descriptor, -1 if not available
+***************************************************************** */
+static int bench_cycles_open(void){
+	struct perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.size = sizeof(attr);
+	attr.config = PERF_COUNT_HW_CPU_CYCLES;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+/** ****************************************************************
+ * Read cycle counter
+ *
+ * @param fd counter file descriptor, -1 if not available
+ * @brief function that read the cycle counter
+ * @return cycles since counter opening, 0 if not available
+***************************************************************** */
+static uint64_t bench_cycles(int fd){
+	uint64_t c = 0;
+	if(fd < 0 || read(fd, &c, sizeof(c)) != sizeof(c))
+		return 0;
+	return c;
+}
+
+/** ****************************************************************
+ * Time a loop
+ *
+ * @param m model context, reset first
+ * @param f frames
+ * @param k kernel
+ * @param with_run 0 to only time the loads of the kernel
+ * @param ops number of calls
+ * @param fd cycle counter, -1 if not available
+ * @param ns elapsed time (in ns)
+ * @param cycles elapsed cycles, 0 if not available
+ * @brief function that call a kernel ops times, on frames in turn
+ * @return 0 when ok
+ * @note a first pass over the frames warms caches and branch predictors
+ * @note variables are reset once per pass over the frames, so the model never dies
+***************************************************************** */
+static int bench_loop(model_t *m, const bench_frame_t *f, const bench_kernel_t *k, int with_run, long ops,
+		int fd, uint64_t *ns, uint64_t *cycles){
+	uint64_t t0 = 0, c0 = 0;
+	long i;
+	int j;
+	bench_reset(m);
+	for(i=-BENCH_FRAMES; i<ops; i++){
+		if(i == 0){
+			c0 = bench_cycles(fd);
+			t0 = monotonic_ns();
+		}
+		if((i & (BENCH_FRAMES-1)) == 0){
+			for(j=0; j<NEED_COUNT; j++)
+				m->var[j] = HOMEO_ONE;
+			m->var_dirty = NEED_ALL;
+		}
+		if(k->load != NULL)
+			k->load(m, &f[i & (BENCH_FRAMES-1)]);
+		if(with_run)
+			k->run(m, &f[i & (BENCH_FRAMES-1)]);
+	}
+	*ns = monotonic_ns() - t0;
+	*cycles = bench_cycles(fd) - c0;
+	return 0;
+}
+
+/** ****************************************************************
+ * Benchmark a frame set
+ *
+ * @param m model context
+ * @param f frames
+ * @param set name of frame set in results
+ * @param ops number of calls of each kernel
+ * @param fd cycle counter, -1 if not available
+ * @param out CSV results
+ * @brief function that benchmark every kernel on a frame set
+ * @return 0 when ok
+***************************************************************** */
+static int bench_set(model_t *m, bench_frame_t *f, const char *set, long ops, int fd, FILE *out){
+	uint64_t ns, cycles, load_ns, load_cycles;
+	unsigned int i;
+	bench_prepare(m, f, BENCH_FRAMES);
+	for(i=0; i<sizeof(kernels)/sizeof(kernels[0]); i++){
+		load_ns = 0;
+		load_cycles = 0;
+		if(kernels[i].load != NULL)
+			bench_loop(m, f, &kernels[i], 0, ops, fd, &load_ns, &load_cycles);
+		bench_loop(m, f, &kernels[i], 1, ops, fd, &ns, &cycles);
+		ns = ns > load_ns ? ns - load_ns : 0;
+		cycles = cycles > load_cycles ? cycles - load_cycles : 0;
+		fprintf(out, "%s,%s,%s,%s,%d,%ld,%.2f,", kernels[i].name, set, NUMERIC_NAME, BENCH_SIMD, BENCH_PROBES,
+			ops, (double)ns/ops);
+		if(fd >= 0)
+			fprintf(out, "%.1f\n", (double)cycles/ops);
+		else
+			fprintf(out, "\n");
+	}
+	return 0;
+}
+
+/** ****************************************************************
+ * Benchmark entry point
+ *
+ * @param argc number of program arguments
+ * @param argv program arguments, -k [-n ops] [-p telemetry.bin] [-o bench.csv]
+ * @brief function that benchmark model kernels on synthetic frames, and recorded frames with -p
+ * @return 0 when ok, -1 if error
+ * @note CSV columns are kernel, frames, numeric, simd, probes, ops, ns_per_op, cycles_per_op (empty without cycle counter)
+***************************************************************** */
+int bench_main(int argc, char *argv[]){
+	static bench_frame_t frames[BENCH_FRAMES];
+	const char *recorded = NULL;
+	FILE *out = stdout;
+	model_t *m = NULL;
+	long ops = BENCH_OPS;
+	int i, fd, r = 0;
+
+	for(i=2; i<argc; i++){
+		if(strcmp(argv[i],"-n")==0 && i+1<argc)
+			ops = atol(argv[++i]);
+		else if(strcmp(argv[i],"-p")==0 && i+1<argc)
+			recorded = argv[++i];
+		else if(strcmp(argv[i],"-o")==0 && i+1<argc){
+			out = fopen(argv[++i], "w");
+			if(out == NULL){
+				printf("ERROR: could not open %s\n", argv[i]);
+				return -1;
+			}
+		}
+	}
+	if(ops <= 0){
+		printf("ERROR: invalid number of calls %ld\n", ops);
+		return -1;
+	}
+	// model context is big and history is cache line aligned
+	if(posix_memalign((void**)&m, HISTORY_ALIGN, sizeof(model_t)) != 0){
+		printf("ERROR: could not allocate model context\n");
+		return -1;
+	}
+	fd = bench_cycles_open();
+	if(fd >= 0)
+		ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+
+	fprintf(out, "kernel,frames,numeric,simd,probes,ops,ns_per_op,cycles_per_op\n");
+	bench_synthetic(frames, BENCH_FRAMES);
+	bench_set(m, frames, "synthetic", ops, fd, out);
+	if(recorded != NULL){
+		if(bench_recorded(frames, BENCH_FRAMES, recorded) < 0)
+			r = -1;
+		else
+			bench_set(m, frames, "recorded", ops, fd, out);
+	}
+
+	if(fd >= 0)
+		close(fd);
+	if(out != stdout)
+		fclose(out);
+	free(m);
+	return r;
+}
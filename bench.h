@@ -0,0 +1,20 @@
+/** ****************************************************************
+ * @file bench.h
+ * @brief Micro-benchmarks of the per-tick kernels of the model.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * Each kernel runs on a set of synthetic or recorded IR frames, results
+ * are printed as CSV (ns and cycles per call) with the numeric policy and
+ * SIMD variant of the build, so runs of several builds can be compared.
+***************************************************************** */
+#ifndef BENCH_H
+#define BENCH_H
+
+#define BENCH_FRAMES 256 ///< frames of a benchmark set, kernels loop over them (power of 2)
+#define BENCH_OPS 200000 ///< default number of calls of each kernel
+
+int bench_main(int argc, char *argv[]);
+
+#endif
@@ -0,0 +1,73 @@
+/** ****************************************************************
+ * @file braitenberg.c
+ * @brief Braitenberg vehicle kernel for danger avoidance.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * Each row is two float32x4 multiply-accumulates followed by a pairwise
+ * sum, scalar fallback does the same operations in the same order
+ * ((p0+p1) + (p2+p3) with pj = wj*sj + wj+4*sj+4), so both paths are bit exact.
+***************************************************************** */
+#include "braitenberg.h"
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+/** ****************************************************************
+ * Clamp a wheel command
+ *
+ * @param v wheel command
+ * @brief function that keep a wheel command in [-1.0, 1.0]
+ * @return clamped command
+***************************************************************** */
+static float braitenberg_clamp(float v){
+	return v > 1.0f ? 1.0f : (v < -1.0f ? -1.0f : v);
+}
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+/** ****************************************************************
+ * Evaluate Braitenberg vehicle (NEON)
+ *
+ * @param b weights
+ * @param sensors clamped IR sensors
+ * @param scale factor normalizing sensors in [0, 1]
+ * @param out left and right wheel commands in [-1.0, 1.0], written
+ * @brief function that compute wheel commands from sensors
+ * @return 0 when ok
+***************************************************************** */
+int braitenberg_eval(const braitenberg_t *b, const int sensors[8], float scale, float out[2]){
+	float32x4_t s0 = vcvtq_f32_s32(vld1q_s32(sensors));
+	float32x4_t s1 = vcvtq_f32_s32(vld1q_s32(sensors+4));
+	float32x4_t l = vmlaq_f32(vmulq_f32(vld1q_f32(b->w[0]), s0), vld1q_f32(b->w[0]+4), s1);
+	float32x4_t r = vmlaq_f32(vmulq_f32(vld1q_f32(b->w[1]), s0), vld1q_f32(b->w[1]+4), s1);
+	// lane 0 is (l0+l1) + (l2+l3), lane 1 is (r0+r1) + (r2+r3)
+	float32x2_t p = vpadd_f32(vpadd_f32(vget_low_f32(l), vget_high_f32(l)), vpadd_f32(vget_low_f32(r), vget_high_f32(r)));
+	p = vmla_n_f32(vld1_f32(b->bias), p, scale);
+	out[0] = braitenberg_clamp(vget_lane_f32(p, 0));
+	out[1] = braitenberg_clamp(vget_lane_f32(p, 1));
+	return 0;
+}
+#else
+/** ****************************************************************
+ * Evaluate Braitenberg vehicle (scalar)
+ *
+ * @param b weights
+ * @param sensors clamped IR sensors
+ * @param scale factor normalizing sensors in [0, 1]
+ * @param out left and right wheel commands in [-1.0, 1.0], written
+ * @brief function that compute wheel commands from sensors
+ * @return 0 when ok
+***************************************************************** */
+int braitenberg_eval(const braitenberg_t *b, const int sensors[8], float scale, float out[2]){
+	float p[4], sum;
+	int k, j;
+	for(k=0; k<2; k++){
+		for(j=0; j<4; j++)
+			p[j] = b->w[k][j]*(float)sensors[j] + b->w[k][j+4]*(float)sensors[j+4];
+		sum = (p[0]+p[1]) + (p[2]+p[3]);
+		out[k] = braitenberg_clamp(b->bias[k] + sum*scale);
+	}
+	return 0;
+}
+#endif
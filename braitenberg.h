@@ -0,0 +1,28 @@
+/** ****************************************************************
+ * @file braitenberg.h
+ * @brief Braitenberg vehicle kernel for danger avoidance.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * Wheel commands are a bias plus a 2x8 weight matrix times the clamped
+ * IR sensors, evaluated as one NEON matrix-vector product on the robot,
+ * scalar fallback elsewhere, both give the same results.
+***************************************************************** */
+#ifndef BRAITENBERG_H
+#define BRAITENBERG_H
+
+/** ****************************************************************
+ * Braitenberg weights
+ *
+ * @brief weight matrix and bias of both wheels, row 0 is left wheel, row 1 is right wheel
+ * @note sensors are in Khepera IV order: back left, left, front left, front, front right, right, back right, back
+***************************************************************** */
+typedef struct {
+	float w[2][8]; ///< weight of each sensor on each wheel, for sensors scaled by 2/(max_dist-min_dist): in [0, 1], 2*max_dist/(max_dist-min_dist) (2.38 by default) when saturated
+	float bias[2]; ///< wheel command without obstacle
+} __attribute__((aligned(16))) braitenberg_t;
+
+int braitenberg_eval(const braitenberg_t *b, const int sensors[8], float scale, float out[2]);
+
+#endif
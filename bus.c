@@ -0,0 +1,416 @@
+/** ****************************************************************
+ * @file bus.c
+ * @brief Owner thread of the dsPic bus of Khepera IV.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * Reads are queued in order on the stack of their caller, which waits
+ * for the result. Writes have one pending slot per kind (mode, speed,
+ * leds): a newer write replaces the pending one. Mode and speed writes
+ * are sent in the order of their last request, so a stop (speed 0 then
+ * idle mode) keeps its order.
+***************************************************************** */
+#include "bus.h"
+#include "probe.h"
+#include "rt.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+/** ****************************************************************
+ * Read request kinds
+ *
+ * @brief synchronous transactions of BUS_SENSORS class
+***************************************************************** */
+enum {
+	BUS_IR = 0, ///< hal_proximity_ir()
+	BUS_US, ///< hal_measure_us()
+	BUS_ACTIVATE_US, ///< hal_activate_us()
+	BUS_BATTERY, ///< hal_battery_status()
+	BUS_CHARGE ///< hal_battery_charge()
+};
+
+/** ****************************************************************
+ * Read request
+ *
+ * @brief synchronous request, lives on the stack of the waiting caller
+***************************************************************** */
+typedef struct bus_req {
+	int kind; ///< request kind (BUS_IR...)
+	int arg; ///< argument of request (ultrasound mask)
+	char *buf; ///< buffer filled by the transaction
+	int ret; ///< HAL result
+	int done; ///< 1 once the transaction is done
+	uint64_t t_ns; ///< request time
+	struct bus_req *next; ///< next request in queue
+} bus_req_t;
+
+/** ****************************************************************
+ * Bus state
+ *
+ * @brief requests waiting for the bus owner
+ * @note all fields are protected by lock
+***************************************************************** */
+static struct {
+	hal_dev_t *dev; ///< owned robot device
+	pthread_t thread; ///< bus owner thread
+	pthread_mutex_t lock; ///< protect requests
+	pthread_cond_t cond; ///< signal new requests
+	pthread_cond_t done; ///< signal done read requests
+	int running; ///< 1 when owner thread is started
+	int quit; ///< 1 when owner thread must exit once writes are sent
+	bus_req_t *head; ///< first read request
+	bus_req_t *tail; ///< last read request
+	uint32_t seq; ///< order of motor write requests
+	int mode_pending; ///< 1 when a mode write is waiting
+	int mode; ///< pending mode
+	uint32_t mode_seq; ///< order of pending mode write
+	uint64_t mode_t_ns; ///< request time of pending mode write
+	int speed_pending; ///< 1 when a speed write is waiting
+	int speed[2]; ///< pending left and right speeds
+	uint32_t speed_seq; ///< order of pending speed write
+	uint64_t speed_t_ns; ///< request time of pending speed write
+	int leds_pending; ///< 1 when a LED write is waiting
+	int leds[9]; ///< pending rgb values of left, right and back leds
+	uint64_t leds_t_ns; ///< request time of pending LED write
+	unsigned long transactions[BUS_CLASSES]; ///< transactions done
+	unsigned long coalesced; ///< pending writes replaced by a newer one
+	unsigned long errors; ///< writes that failed
+	uint64_t max_wait_ns[BUS_CLASSES]; ///< worst time between a request and its transaction
+} bus = {.lock = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER, .done = PTHREAD_COND_INITIALIZER};
+
+/** ****************************************************************
+ * Read transaction
+ *
+ * @param dev robot device
+ * @param kind request kind
+ * @param arg argument of request
+ * @param buf buffer to fill
+ * @brief function that do a read transaction on the bus
+ * @return HAL result
+***************************************************************** */
+static int bus_read(hal_dev_t *dev, int kind, int arg, char *buf){
+	int ret = -1;
+	switch(kind){
+		case BUS_IR: PROBE_CALL(PROBE_BUS_IR, ret = hal_proximity_ir(dev, buf)); break;
+		case BUS_US: PROBE_CALL(PROBE_BUS_US, ret = hal_measure_us(dev, buf)); break;
+		case BUS_ACTIVATE_US: ret = hal_activate_us(dev, arg); break;
+		case BUS_BATTERY: PROBE_CALL(PROBE_BUS_BATTERY, ret = hal_battery_status(dev, buf)); break;
+		case BUS_CHARGE: PROBE_CALL(PROBE_BUS_BATTERY, ret = hal_battery_charge(dev)); break;
+	}
+	return ret;
+}
+
+/** ****************************************************************
+ * Account a transaction
+ *
+ * @param cls request class
+ * @param t_ns request time
+ * @brief function that count a transaction and its wait
+ * @return 0 when ok
+ * @note called with lock held
+***************************************************************** */
+static int bus_account(int cls, uint64_t t_ns){
+	uint64_t wait = hal_now_ns(NULL) - t_ns;
+	bus.transactions[cls]++;
+	if(wait > bus.max_wait_ns[cls])
+		bus.max_wait_ns[cls] = wait;
+	return 0;
+}
+
+/** ****************************************************************
+ * Serve a request
+ *
+ * @brief function that do the transaction of the highest priority request
+ * @return 0 when ok
+ * @note called with lock held, the lock is released during the transaction
+***************************************************************** */
+static int bus_serve(void){
+	bus_req_t *r;
+	int ret, a, b, v[9];
+	if(bus.mode_pending && (!bus.speed_pending || (int32_t)(bus.mode_seq - bus.speed_seq) < 0)){
+		a = bus.mode;
+		bus.mode_pending = 0;
+		bus_account(BUS_MOTORS, bus.mode_t_ns);
+		pthread_mutex_unlock(&bus.lock);
+		PROBE_CALL(PROBE_BUS_MODE, ret = hal_set_mode(bus.dev, a));
+		pthread_mutex_lock(&bus.lock);
+	}
+	else if(bus.speed_pending){
+		a = bus.speed[0];
+		b = bus.speed[1];
+		bus.speed_pending = 0;
+		bus_account(BUS_MOTORS, bus.speed_t_ns);
+		pthread_mutex_unlock(&bus.lock);
+		PROBE_CALL(PROBE_BUS_SPEED, ret = hal_set_speed(bus.dev, a, b));
+		pthread_mutex_lock(&bus.lock);
+	}
+	else if(bus.head != NULL){
+		r = bus.head;
+		bus.head = r->next;
+		if(bus.head == NULL)
+			bus.tail = NULL;
+		bus_account(BUS_SENSORS, r->t_ns);
+		pthread_mutex_unlock(&bus.lock);
+		ret = bus_read(bus.dev, r->kind, r->arg, r->buf);
+		pthread_mutex_lock(&bus.lock);
+		r->ret = ret;
+		r->done = 1;
+		pthread_cond_broadcast(&bus.done);
+		return 0; // read errors are returned to their caller
+	}
+	else{
+		memcpy(v, bus.leds, sizeof(v));
+		bus.leds_pending = 0;
+		bus_account(BUS_LEDS, bus.leds_t_ns);
+		pthread_mutex_unlock(&bus.lock);
+		PROBE_CALL(PROBE_BUS_LEDS, ret = hal_set_leds(bus.dev, v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], v[8]));
+		pthread_mutex_lock(&bus.lock);
+	}
+	if(ret < 0)
+		bus.errors++;
+	return 0;
+}
+
+/** ****************************************************************
+ * Bus owner
+ *
+ * @param args unused
+ * @brief thread that serve bus requests by priority
+***************************************************************** */
+static void* bus_thread(void *args){
+	pthread_mutex_lock(&bus.lock);
+	while(1){
+		while(!bus.quit && !bus.mode_pending && !bus.speed_pending && bus.head == NULL && !bus.leds_pending)
+			pthread_cond_wait(&bus.cond, &bus.lock);
+		if(!bus.mode_pending && !bus.speed_pending && bus.head == NULL && !bus.leds_pending)
+			break; // quit, every write is sent
+		bus_serve();
+	}
+	pthread_mutex_unlock(&bus.lock);
+	return NULL;
+}
+
+/** ****************************************************************
+ * Tell if bus is owned
+ *
+ * @param dev robot device of the call
+ * @brief function that tell if calls for a device go through the owner thread
+ * @return 1 when owned, 0 otherwise
+***************************************************************** */
+static int bus_owned(hal_dev_t *dev){
+	return dev == bus.dev && __atomic_load_n(&bus.running, __ATOMIC_ACQUIRE);
+}
+
+/** ****************************************************************
+ * Read request
+ *
+ * @param dev robot device
+ * @param kind request kind
+ * @param arg argument of request
+ * @param buf buffer to fill
+ * @brief function that queue a read and wait for its transaction
+ * @return HAL result
+***************************************************************** */
+static int bus_call(hal_dev_t *dev, int kind, int arg, char *buf){
+	bus_req_t r;
+	if(!bus_owned(dev))
+		return bus_read(dev, kind, arg, buf);
+	memset(&r, 0, sizeof(r));
+	r.kind = kind;
+	r.arg = arg;
+	r.buf = buf;
+	r.t_ns = hal_now_ns(NULL);
+	pthread_mutex_lock(&bus.lock);
+	if(bus.tail != NULL)
+		bus.tail->next = &r;
+	else
+		bus.head = &r;
+	bus.tail = &r;
+	pthread_cond_signal(&bus.cond);
+	while(!r.done)
+		pthread_cond_wait(&bus.done, &bus.lock);
+	pthread_mutex_unlock(&bus.lock);
+	return r.ret;
+}
+
+/** ****************************************************************
+ * Start bus owner
+ *
+ * @param dev robot device, owned by the bus thread from now on
+ * @brief function that start the bus owner thread
+ * @return 0 when ok, -1 if error
+ * @note no thread is started in simulation, calls go straight to the simulated robot
+***************************************************************** */
+int bus_start(hal_dev_t *dev){
+	bus.dev = dev;
+	bus.quit = 0;
+	if(hal_is_simulated())
+		return 0;
+	if(pthread_create(&bus.thread, NULL, &bus_thread, NULL) != 0){
+		printf("ERROR: could not create bus thread\n");
+		return -1;
+	}
+	__atomic_store_n(&bus.running, 1, __ATOMIC_RELEASE);
+	return 0;
+}
+
+/** ****************************************************************
+ * Stop bus owner
+ *
+ * @brief function that send pending writes, stop owner thread and print bus stats
+ * @return 0 when ok
+ * @note call it once every thread using the bus is stopped
+***************************************************************** */
+int bus_stop(void){
+	if(!bus.running)
+		return 0;
+	pthread_mutex_lock(&bus.lock);
+	bus.quit = 1;
+	pthread_cond_signal(&bus.cond);
+	pthread_mutex_unlock(&bus.lock);
+	pthread_join(bus.thread, NULL);
+	__atomic_store_n(&bus.running, 0, __ATOMIC_RELEASE);
+	printf("Bus: %lu motor, %lu sensor, %lu LED transactions | %lu coalesced writes | %lu write errors | worst wait %.2f / %.2f / %.2f ms\n",
+		bus.transactions[BUS_MOTORS], bus.transactions[BUS_SENSORS], bus.transactions[BUS_LEDS], bus.coalesced, bus.errors,
+		bus.max_wait_ns[BUS_MOTORS]/1000000.0, bus.max_wait_ns[BUS_SENSORS]/1000000.0, bus.max_wait_ns[BUS_LEDS]/1000000.0);
+	return 0;
+}
+
+/** ****************************************************************
+ * Set bus thread class
+ *
+ * @param cls thread class (see rt.h)
+ * @brief function that set scheduling class of the bus owner, it serves the control path
+ * @return 0 when ok, -1 if error
+***************************************************************** */
+int bus_thread_class(int cls){
+	if(!bus.running)
+		return 0;
+	return rt_set(bus.thread, cls);
+}
+
+/** ****************************************************************
+ * Read proximity sensors, 12 little endian values
+ *
+ * @brief function that read proximity sensors through the bus owner
+ * @return HAL result, <0 if error
+***************************************************************** */
+int bus_proximity_ir(hal_dev_t *dev, char *buf){
+	return bus_call(dev, BUS_IR, 0, buf);
+}
+
+/** ****************************************************************
+ * Read ultrasound sensors, 5 little endian values
+ *
+ * @brief function that read ultrasound sensors through the bus owner
+ * @return HAL result, <0 if error
+***************************************************************** */
+int bus_measure_us(hal_dev_t *dev, char *buf){
+	return bus_call(dev, BUS_US, 0, buf);
+}
+
+/** ****************************************************************
+ * Activate ultrasound sensors of mask
+ *
+ * @brief function that activate ultrasound sensors through the bus owner
+ * @return HAL result, <0 if error
+***************************************************************** */
+int bus_activate_us(hal_dev_t *dev, int mask){
+	return bus_call(dev, BUS_ACTIVATE_US, mask, NULL);
+}
+
+/** ****************************************************************
+ * Read battery status, 12 bytes
+ *
+ * @brief function that read battery status through the bus owner
+ * @return HAL result, <0 if error
+***************************************************************** */
+int bus_battery_status(hal_dev_t *dev, char *buf){
+	return bus_call(dev, BUS_BATTERY, 0, buf);
+}
+
+/** ****************************************************************
+ * Tell if charger is plugged
+ *
+ * @brief function that read charger state through the bus owner
+ * @return HAL result, <0 if error
+***************************************************************** */
+int bus_battery_charge(hal_dev_t *dev){
+	return bus_call(dev, BUS_CHARGE, 0, NULL);
+}
+
+/** ****************************************************************
+ * Set motor controller mode (HAL_MODE_IDLE or HAL_MODE_SPEED)
+ *
+ * @brief function that queue a mode write, never wait for the bus
+ * @return 0 when queued, HAL result when not owned
+***************************************************************** */
+int bus_set_mode(hal_dev_t *dev, int mode){
+	int ret;
+	if(!bus_owned(dev)){
+		PROBE_CALL(PROBE_BUS_MODE, ret = hal_set_mode(dev, mode));
+		return ret;
+	}
+	pthread_mutex_lock(&bus.lock);
+	if(bus.mode_pending)
+		bus.coalesced++;
+	bus.mode = mode;
+	bus.mode_seq = bus.seq++;
+	bus.mode_t_ns = hal_now_ns(NULL);
+	bus.mode_pending = 1;
+	pthread_cond_signal(&bus.cond);
+	pthread_mutex_unlock(&bus.lock);
+	return 0;
+}
+
+/** ****************************************************************
+ * Set wheel speeds
+ *
+ * @brief function that queue a speed write, never wait for the bus
+ * @return 0 when queued, HAL result when not owned
+***************************************************************** */
+int bus_set_speed(hal_dev_t *dev, int left, int right){
+	int ret;
+	if(!bus_owned(dev)){
+		PROBE_CALL(PROBE_BUS_SPEED, ret = hal_set_speed(dev, left, right));
+		return ret;
+	}
+	pthread_mutex_lock(&bus.lock);
+	if(bus.speed_pending)
+		bus.coalesced++;
+	bus.speed[0] = left;
+	bus.speed[1] = right;
+	bus.speed_seq = bus.seq++;
+	bus.speed_t_ns = hal_now_ns(NULL);
+	bus.speed_pending = 1;
+	pthread_cond_signal(&bus.cond);
+	pthread_mutex_unlock(&bus.lock);
+	return 0;
+}
+
+/** ****************************************************************
+ * Set rgb color of left, right and back leds
+ *
+ * @brief function that queue a LED write, never wait for the bus
+ * @return 0 when queued, HAL result when not owned
+***************************************************************** */
+int bus_set_leds(hal_dev_t *dev, int lr, int lg, int lb, int rr, int rg, int rb, int br, int bg, int bb){
+	int ret;
+	if(!bus_owned(dev)){
+		PROBE_CALL(PROBE_BUS_LEDS, ret = hal_set_leds(dev, lr, lg, lb, rr, rg, rb, br, bg, bb));
+		return ret;
+	}
+	pthread_mutex_lock(&bus.lock);
+	if(bus.leds_pending)
+		bus.coalesced++;
+	bus.leds[0] = lr; bus.leds[1] = lg; bus.leds[2] = lb;
+	bus.leds[3] = rr; bus.leds[4] = rg; bus.leds[5] = rb;
+	bus.leds[6] = br; bus.leds[7] = bg; bus.leds[8] = bb;
+	bus.leds_t_ns = hal_now_ns(NULL);
+	bus.leds_pending = 1;
+	pthread_cond_signal(&bus.cond);
+	pthread_mutex_unlock(&bus.lock);
+	return 0;
+}
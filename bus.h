@@ -0,0 +1,45 @@
+/** ****************************************************************
+ * @file bus.h
+ * @brief Owner thread of the dsPic bus of Khepera IV.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * A single thread owns the robot device and serves the bus requests of
+ * every other thread by priority: motor writes first, then sensor reads,
+ * then LED writes. Reads wait for their transaction, writes are queued
+ * and a pending write is replaced by a newer one of the same kind.
+ * Functions take the same arguments as hal.h, calls for another device
+ * or in simulation go straight to the HAL.
+***************************************************************** */
+#ifndef BUS_H
+#define BUS_H
+
+#include "hal.h"
+
+/** ****************************************************************
+ * Request classes
+ *
+ * @brief bus requests, by decreasing priority
+***************************************************************** */
+enum {
+	BUS_MOTORS = 0, ///< motor mode and speed writes
+	BUS_SENSORS, ///< sensor reads, battery reads and ultrasound activation, served in order
+	BUS_LEDS, ///< LED writes
+	BUS_CLASSES ///< number of request classes
+};
+
+int bus_start(hal_dev_t *dev);
+int bus_stop(void);
+int bus_thread_class(int cls);
+
+int bus_proximity_ir(hal_dev_t *dev, char *buf);
+int bus_measure_us(hal_dev_t *dev, char *buf);
+int bus_activate_us(hal_dev_t *dev, int mask);
+int bus_battery_status(hal_dev_t *dev, char *buf);
+int bus_battery_charge(hal_dev_t *dev);
+int bus_set_mode(hal_dev_t *dev, int mode);
+int bus_set_speed(hal_dev_t *dev, int left, int right);
+int bus_set_leds(hal_dev_t *dev, int lr, int lg, int lb, int rr, int rg, int rb, int br, int bg, int bb);
+
+#endif
@@ -0,0 +1,634 @@
+/** ****************************************************************
+ * @file experiment.c
+ * @brief Columnar experiment files for offline analysis.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * Writer packing telemetry records in column chunks and reader mapping an
+ * experiment file and decoding the columns of a query, see experiment.h.
+***************************************************************** */
+#define _FILE_OFFSET_BITS 64
+#include "experiment.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/// biggest encoded size of a column chunk (varint of 64 bits is 10 bytes)
+#define EXPERIMENT_BUF (EXPERIMENT_CHUNK*10 + 1)
+
+/** ****************************************************************
+ * Add a column
+ *
+ * @param w writer
+ * @param name column name
+ * @param type column type
+ * @param offset offset of the value in telemetry_record_t (in bytes)
+ * @brief function that add a column to the writer
+ * @return 0 when ok
+***************************************************************** */
+static int add_column(experiment_writer_t *w, const char *name, int type, size_t offset){
+	experiment_column_t *c = &w->column[w->columns++];
+	memset(c, 0, sizeof(*c));
+	snprintf(c->name, sizeof(c->name), "%s", name);
+	c->type = type;
+	c->offset = offset;
+	return 0;
+}
+
+/** ****************************************************************
+ * Add array columns
+ *
+ * @param w writer
+ * @param prefix column name prefix
+ * @param names element names, NULL for element numbers
+ * @param n number of elements
+ * @param type column type
+ * @param offset offset of the array in telemetry_record_t (in bytes)
+ * @param size size of an element (in bytes)
+ * @brief function that add one column per element of a record array
+ * @return 0 when ok
+***************************************************************** */
+static int add_columns(experiment_writer_t *w, const char *prefix, const char *const *names, int n, int type, size_t offset, size_t size){
+	char name[EXPERIMENT_NAME];
+	int i;
+	for(i=0; i<n; i++){
+		if(names)
+			snprintf(name, sizeof(name), "%s_%s", prefix, names[i]);
+		else
+			snprintf(name, sizeof(name), "%s_%d", prefix, i);
+		add_column(w, name, type, offset + i*size);
+	}
+	return 0;
+}
+
+/** ****************************************************************
+ * Column table of telemetry records
+ *
+ * @param w writer
+ * @brief function that describe every signal of telemetry_record_t, in telemetry_decode order
+ * @return 0 when ok
+***************************************************************** */
+static int record_columns(experiment_writer_t *w){
+	#define ARRAY(prefix, names, field, type) add_columns(w, prefix, names, \
+		sizeof(((telemetry_record_t*)0)->field)/sizeof(((telemetry_record_t*)0)->field[0]), \
+		type, offsetof(telemetry_record_t, field), sizeof(((telemetry_record_t*)0)->field[0]))
+	w->columns = 0;
+	add_column(w, "t_ns", EXPERIMENT_U64, offsetof(telemetry_record_t, t_ns));
+	add_column(w, "tick", EXPERIMENT_U32, offsetof(telemetry_record_t, tick));
+	add_column(w, "behaviour", EXPERIMENT_I32, offsetof(telemetry_record_t, behaviour));
+	ARRAY("var", need_names, var, EXPERIMENT_F32);
+	ARRAY("def", need_names, def, EXPERIMENT_F32);
+	ARRAY("cue", need_names, cue, EXPERIMENT_F32);
+	ARRAY("mot", need_names, mot, EXPERIMENT_F32);
+	ARRAY("sensor", NULL, sensors, EXPERIMENT_I16);
+	ARRAY("speed", NULL, speed, EXPERIMENT_F32);
+	ARRAY("circ_speed", NULL, circ_speed, EXPERIMENT_F32);
+	add_column(w, "left_speed", EXPERIMENT_F32, offsetof(telemetry_record_t, left_speed));
+	add_column(w, "right_speed", EXPERIMENT_F32, offsetof(telemetry_record_t, right_speed));
+	add_column(w, "dt", EXPERIMENT_F32, offsetof(telemetry_record_t, dt));
+	ARRAY("stage_ns", NULL, stage_ns, EXPERIMENT_U32);
+	ARRAY("ir", NULL, ir, EXPERIMENT_U16);
+	ARRAY("ground", NULL, ground, EXPERIMENT_U16);
+	ARRAY("us", NULL, us, EXPERIMENT_U16);
+	add_column(w, "us_t_ns", EXPERIMENT_U64, offsetof(telemetry_record_t, us_t_ns));
+	add_column(w, "battery", EXPERIMENT_I16, offsetof(telemetry_record_t, battery));
+	add_column(w, "current", EXPERIMENT_I16, offsetof(telemetry_record_t, current));
+	add_column(w, "tier", EXPERIMENT_I16, offsetof(telemetry_record_t, tier));
+	ARRAY("tier_ms", NULL, tier_ms, EXPERIMENT_U32);
+	#undef ARRAY
+	return 0;
+}
+
+/** ****************************************************************
+ * Read a value
+ *
+ * @param r telemetry record
+ * @param c column
+ * @brief function that give the value of a column in a record
+ * @return value, floats as their bit pattern
+***************************************************************** */
+static int64_t column_value(const telemetry_record_t *r, const experiment_column_t *c){
+	const unsigned char *p = (const unsigned char*)r + c->offset;
+	uint64_t u64;
+	uint32_t u32;
+	int32_t i32;
+	uint16_t u16;
+	int16_t i16;
+	switch(c->type){
+		case EXPERIMENT_U64: memcpy(&u64, p, sizeof(u64)); return (int64_t)u64;
+		case EXPERIMENT_U32: memcpy(&u32, p, sizeof(u32)); return u32;
+		case EXPERIMENT_I32: memcpy(&i32, p, sizeof(i32)); return i32;
+		case EXPERIMENT_U16: memcpy(&u16, p, sizeof(u16)); return u16;
+		case EXPERIMENT_I16: memcpy(&i16, p, sizeof(i16)); return i16;
+		default: memcpy(&u32, p, sizeof(u32)); return u32;
+	}
+}
+
+/** ****************************************************************
+ * Put a varint
+ *
+ * @param p output buffer
+ * @param v value
+ * @brief function that write 7 bits per byte, high bit set when more bytes follow
+ * @return number of bytes written
+***************************************************************** */
+static size_t put_varint(unsigned char *p, uint64_t v){
+	size_t n = 0;
+	while(v >= 0x80){
+		p[n++] = (unsigned char)(v | 0x80);
+		v >>= 7;
+	}
+	p[n++] = (unsigned char)v;
+	return n;
+}
+
+/** ****************************************************************
+ * Get a varint
+ *
+ * @param p input buffer
+ * @param end end of input buffer
+ * @param v value read
+ * @brief function that read a varint written by put_varint
+ * @return number of bytes read, 0 if buffer is truncated
+***************************************************************** */
+static size_t get_varint(const unsigned char *p, const unsigned char *end, uint64_t *v){
+	size_t n = 0;
+	int shift = 0;
+	*v = 0;
+	while(p + n < end && shift < 64){
+		*v |= (uint64_t)(p[n] & 0x7f) << shift;
+		if(!(p[n++] & 0x80))
+			return n;
+		shift += 7;
+	}
+	return 0;
+}
+
+/** ****************************************************************
+ * Encode a column chunk
+ *
+ * @param raw values of the column
+ * @param rows number of values
+ * @param codec EXPERIMENT_DELTA or EXPERIMENT_DELTA2
+ * @param out output buffer, EXPERIMENT_BUF bytes
+ * @brief function that encode residuals as zigzag varints, runs of 0 as a 0 and a count
+ * @return number of bytes written, codec byte included
+***************************************************************** */
+static size_t encode(const int64_t *raw, uint32_t rows, int codec, unsigned char *out){
+	uint64_t prev = 0, prev_delta = 0, delta, res, zeros = 0;
+	size_t n = 0;
+	uint32_t i;
+	out[n++] = (unsigned char)codec;
+	for(i=0; i<rows; i++){
+		delta = (uint64_t)raw[i] - prev; // modular, any 64 bits value round trips
+		prev = raw[i];
+		res = codec == EXPERIMENT_DELTA2 ? delta - prev_delta : delta;
+		prev_delta = delta;
+		if(res == 0){
+			zeros++;
+			continue;
+		}
+		if(zeros){
+			n += put_varint(out + n, 0);
+			n += put_varint(out + n, zeros - 1);
+			zeros = 0;
+		}
+		n += put_varint(out + n, (res << 1) ^ (uint64_t)((int64_t)res >> 63));
+	}
+	if(zeros){
+		n += put_varint(out + n, 0);
+		n += put_varint(out + n, zeros - 1);
+	}
+	return n;
+}
+
+/** ****************************************************************
+ * Decode a column chunk
+ *
+ * @param p encoded column
+ * @param end end of encoded column
+ * @param rows number of values
+ * @param raw decoded values
+ * @brief function that decode a column encoded by encode()
+ * @return 0 when ok, -1 if column is corrupted
+***************************************************************** */
+static int decode(const unsigned char *p, const unsigned char *end, uint32_t rows, int64_t *raw){
+	uint64_t prev = 0, prev_delta = 0, delta, res, v, zeros = 0;
+	size_t n;
+	uint32_t i;
+	int codec;
+	if(p >= end)
+		return -1;
+	codec = *p++;
+	if(codec != EXPERIMENT_DELTA && codec != EXPERIMENT_DELTA2)
+		return -1;
+	for(i=0; i<rows; i++){
+		if(zeros)
+			zeros--, res = 0;
+		else{
+			if((n = get_varint(p, end, &v)) == 0)
+				return -1;
+			p += n;
+			if(v == 0){
+				if((n = get_varint(p, end, &zeros)) == 0)
+					return -1;
+				p += n;
+			}
+			res = (v >> 1) ^ (0 - (v & 1));
+		}
+		delta = codec == EXPERIMENT_DELTA2 ? prev_delta + res : res;
+		prev_delta = delta;
+		prev += delta;
+		raw[i] = (int64_t)prev;
+	}
+	return 0;
+}
+
+/** ****************************************************************
+ * Grow chunk tables
+ *
+ * @param w writer
+ * @brief function that make room for one more chunk in the footer tables
+ * @return 0 when ok, -1 if error
+***************************************************************** */
+static int grow(experiment_writer_t *w){
+	experiment_chunk_t *chunk;
+	uint32_t *offsets;
+	uint32_t cap;
+	if(w->chunks < w->cap)
+		return 0;
+	cap = w->cap ? 2*w->cap : 64;
+	chunk = realloc(w->chunk, cap*sizeof(*chunk));
+	if(chunk)
+		w->chunk = chunk;
+	offsets = realloc(w->offsets, (size_t)cap*(w->columns+1)*sizeof(*offsets));
+	if(offsets)
+		w->offsets = offsets;
+	if(chunk == NULL || offsets == NULL){
+		printf("ERROR: could not allocate %u experiment chunks\n", cap);
+		return -1;
+	}
+	w->cap = cap;
+	return 0;
+}
+
+/** ****************************************************************
+ * Write pending chunk
+ *
+ * @param w writer
+ * @brief function that encode the pending rows, one column after the other, and index them
+ * @return 0 when ok, -1 if error
+***************************************************************** */
+static int flush_chunk(experiment_writer_t *w){
+	experiment_chunk_t *k;
+	experiment_run_t *r;
+	uint32_t *off;
+	size_t n, n2;
+	uint32_t c, pos = 0;
+	int64_t *raw;
+	if(w->rows == 0)
+		return 0;
+	if(grow(w) < 0)
+		return -1;
+	r = &w->run[w->runs-1];
+	k = &w->chunk[w->chunks];
+	off = &w->offsets[(size_t)w->chunks*(w->columns+1)];
+	k->offset = w->pos;
+	k->first_ns = (uint64_t)w->raw[0];
+	k->last_ns = (uint64_t)w->raw[w->rows-1];
+	k->first_tick = (uint32_t)w->raw[EXPERIMENT_CHUNK]; // t_ns and tick are the two first columns
+	k->last_tick = (uint32_t)w->raw[EXPERIMENT_CHUNK + w->rows-1];
+	k->run = w->runs-1;
+	k->rows = w->rows;
+	for(c=0; c<w->columns; c++){
+		raw = &w->raw[(size_t)c*EXPERIMENT_CHUNK];
+		off[c] = pos;
+		n = encode(raw, w->rows, EXPERIMENT_DELTA, w->buf);
+		n2 = encode(raw, w->rows, EXPERIMENT_DELTA2, w->buf + EXPERIMENT_BUF);
+		if(fwrite(n2 < n ? w->buf + EXPERIMENT_BUF : w->buf, n2 < n ? n2 : n, 1, w->file) != 1){
+			printf("ERROR: could not write experiment file\n");
+			return -1;
+		}
+		pos += n2 < n ? n2 : n;
+	}
+	off[w->columns] = pos;
+	w->pos += pos;
+	if(r->rows == 0)
+		r->first_ns = k->first_ns;
+	r->last_ns = k->last_ns;
+	r->rows += w->rows;
+	r->chunks++;
+	w->chunks++;
+	w->rows = 0;
+	return 0;
+}
+
+/** ****************************************************************
+ * Create experiment file
+ *
+ * @param w writer to init
+ * @param path experiment file, truncated
+ * @brief function that open an experiment file and write its header
+ * @return 0 when ok, -1 if error
+***************************************************************** */
+int experiment_create(experiment_writer_t *w, const char *path){
+	experiment_header_t header;
+	memset(w, 0, sizeof(*w));
+	record_columns(w);
+	w->raw = malloc((size_t)w->columns*EXPERIMENT_CHUNK*sizeof(*w->raw));
+	w->buf = malloc(2*EXPERIMENT_BUF);
+	w->file = fopen(path, "wb");
+	if(w->raw == NULL || w->buf == NULL || w->file == NULL){
+		printf("ERROR: could not create experiment file %s\n", path);
+		if(w->file)
+			fclose(w->file);
+		free(w->raw);
+		free(w->buf);
+		return -1;
+	}
+	header.magic = EXPERIMENT_MAGIC;
+	header.version = EXPERIMENT_VERSION;
+	header.telemetry_version = TELEMETRY_VERSION;
+	fwrite(&header, sizeof(header), 1, w->file);
+	w->pos = sizeof(header);
+	return 0;
+}
+
+/** ****************************************************************
+ * Begin a run
+ *
+ * @param w writer
+ * @param name run name, truncated to EXPERIMENT_NAME-1 characters
+ * @brief function that end the current run and start a new one, next records belong to it
+ * @return 0 when ok, -1 if error
+***************************************************************** */
+int experiment_begin_run(experiment_writer_t *w, const char *name){
+	experiment_run_t *run;
+	if(flush_chunk(w) < 0)
+		return -1;
+	run = realloc(w->run, (w->runs+1)*sizeof(*run));
+	if(run == NULL){
+		printf("ERROR: could not allocate experiment run\n");
+		return -1;
+	}
+	w->run = run;
+	run = &w->run[w->runs++];
+	memset(run, 0, sizeof(*run));
+	snprintf(run->name, sizeof(run->name), "%s", name);
+	run->first_chunk = w->chunks;
+	return 0;
+}
+
+/** ****************************************************************
+ * Append a record
+ *
+ * @param w writer, with a run begun
+ * @param r record of the current run
+ * @brief function that add a row to the pending chunk, written when full
+ * @return 0 when ok, -1 if error
+***************************************************************** */
+int experiment_append(experiment_writer_t *w, const telemetry_record_t *r){
+	uint32_t c;
+	if(w->runs == 0){
+		printf("ERROR: experiment record before first run\n");
+		return -1;
+	}
+	for(c=0; c<w->columns; c++)
+		w->raw[(size_t)c*EXPERIMENT_CHUNK + w->rows] = column_value(r, &w->column[c]);
+	w->bytes_in += sizeof(*r);
+	if(++w->rows == EXPERIMENT_CHUNK)
+		return flush_chunk(w);
+	return 0;
+}
+
+/** ****************************************************************
+ * Finish experiment file
+ *
+ * @param w writer
+ * @brief function that write the last chunk, the footer and the trailer, and close the file
+ * @return 0 when ok, -1 if error
+ * @note the footer starts on 8 bytes, so a mapped reader can use its tables in place
+***************************************************************** */
+int experiment_finish(experiment_writer_t *w){
+	static const unsigned char pad[8];
+	experiment_trailer_t trailer;
+	int r = flush_chunk(w);
+	if(r == 0){
+		fwrite(pad, (8 - w->pos % 8) % 8, 1, w->file);
+		trailer.footer = w->pos + (8 - w->pos % 8) % 8;
+		trailer.columns = w->columns;
+		trailer.runs = w->runs;
+		trailer.chunks = w->chunks;
+		trailer.magic = EXPERIMENT_MAGIC;
+		fwrite(w->run, sizeof(*w->run), w->runs, w->file);
+		fwrite(w->chunk, sizeof(*w->chunk), w->chunks, w->file);
+		fwrite(w->offsets, sizeof(*w->offsets)*(w->columns+1), w->chunks, w->file);
+		fwrite(w->column, sizeof(*w->column), w->columns, w->file);
+		fwrite(&trailer, sizeof(trailer), 1, w->file);
+		if(ferror(w->file)){
+			printf("ERROR: could not write experiment file\n");
+			r = -1;
+		}
+	}
+	if(fclose(w->file) != 0)
+		r = -1;
+	free(w->run);
+	free(w->chunk);
+	free(w->offsets);
+	free(w->raw);
+	free(w->buf);
+	w->file = NULL;
+	return r;
+}
+
+/** ****************************************************************
+ * Open experiment file
+ *
+ * @param e reader to init
+ * @param path experiment file
+ * @brief function that map an experiment file and check its footer
+ * @return 0 when ok, -1 if error
+ * @note nothing is decoded, pages of a column are only read when it is decoded
+***************************************************************** */
+int experiment_open(experiment_t *e, const char *path){
+	const experiment_header_t *header;
+	experiment_trailer_t trailer;
+	uint64_t size;
+	struct stat st;
+	void *map;
+	int fd;
+	memset(e, 0, sizeof(*e));
+	fd = open(path, O_RDONLY);
+	if(fd < 0 || fstat(fd, &st) < 0){
+		printf("ERROR: could not open %s\n", path);
+		if(fd >= 0)
+			close(fd);
+		return -1;
+	}
+	if(st.st_size < (off_t)(sizeof(*header) + sizeof(trailer))){
+		printf("ERROR: %s is not an experiment file\n", path);
+		close(fd);
+		return -1;
+	}
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(map == MAP_FAILED){
+		printf("ERROR: could not map %s\n", path);
+		return -1;
+	}
+	e->map = map;
+	e->size = st.st_size;
+	header = map;
+	memcpy(&trailer, e->map + e->size - sizeof(trailer), sizeof(trailer));
+	if(header->magic != EXPERIMENT_MAGIC || trailer.magic != EXPERIMENT_MAGIC){
+		printf("ERROR: %s is not an experiment file\n", path);
+		experiment_close(e);
+		return -1;
+	}
+	if(header->version != EXPERIMENT_VERSION || trailer.columns > EXPERIMENT_COLUMNS){
+		printf("ERROR: unsupported experiment version %d\n", header->version);
+		experiment_close(e);
+		return -1;
+	}
+	size = (uint64_t)trailer.runs*sizeof(experiment_run_t) + (uint64_t)trailer.chunks*sizeof(experiment_chunk_t)
+		+ (uint64_t)trailer.chunks*(trailer.columns+1)*sizeof(uint32_t) + (uint64_t)trailer.columns*sizeof(experiment_column_t);
+	if(trailer.footer % 8 || trailer.footer + size + sizeof(trailer) != e->size){
+		printf("ERROR: %s has a corrupted footer\n", path);
+		experiment_close(e);
+		return -1;
+	}
+	e->columns = trailer.columns;
+	e->runs = trailer.runs;
+	e->chunks = trailer.chunks;
+	e->run = (const experiment_run_t*)(e->map + trailer.footer);
+	e->chunk = (const experiment_chunk_t*)(e->run + e->runs);
+	e->offsets = (const uint32_t*)(e->chunk + e->chunks);
+	e->column = (const experiment_column_t*)(e->offsets + (size_t)e->chunks*(e->columns+1));
+	return 0;
+}
+
+/** ****************************************************************
+ * Close experiment file
+ *
+ * @param e reader
+ * @brief function that unmap an experiment file
+ * @return 0 when ok
+***************************************************************** */
+int experiment_close(experiment_t *e){
+	if(e->map)
+		munmap((void*)e->map, e->size);
+	e->map = NULL;
+	return 0;
+}
+
+/** ****************************************************************
+ * Find a column
+ *
+ * @param e reader
+ * @param name column name
+ * @brief function that give the index of a column
+ * @return column index, -1 if there is no such column
+***************************************************************** */
+int experiment_find(const experiment_t *e, const char *name){
+	uint32_t c;
+	for(c=0; c<e->columns; c++)
+		if(strncmp(e->column[c].name, name, EXPERIMENT_NAME) == 0)
+			return c;
+	return -1;
+}
+
+/** ****************************************************************
+ * Check a chunk time range
+ *
+ * @param e reader
+ * @param chunk chunk index
+ * @param from_ns begin of time range (robot clock, in ns)
+ * @param to_ns end of time range, included (robot clock, in ns)
+ * @brief function that tell from the index if a chunk has rows in a time range
+ * @return 1 if chunk overlaps the range, 0 otherwise
+***************************************************************** */
+int experiment_overlaps(const experiment_t *e, uint32_t chunk, uint64_t from_ns, uint64_t to_ns){
+	const experiment_chunk_t *k = &e->chunk[chunk];
+	return k->first_ns <= to_ns && k->last_ns >= from_ns;
+}
+
+/** ****************************************************************
+ * Decode a chunk column in raw values
+ *
+ * @param e reader
+ * @param chunk chunk index
+ * @param col column index
+ * @param out values, chunk rows
+ * @brief function that decode one column of one chunk
+ * @return number of rows, -1 if error
+***************************************************************** */
+static long decode_raw(const experiment_t *e, uint32_t chunk, int col, int64_t *out){
+	const uint32_t *off;
+	const experiment_chunk_t *k;
+	if(chunk >= e->chunks || col < 0 || (uint32_t)col >= e->columns){
+		printf("ERROR: no chunk %u column %d in experiment\n", chunk, col);
+		return -1;
+	}
+	k = &e->chunk[chunk];
+	off = &e->offsets[(size_t)chunk*(e->columns+1)];
+	if(k->rows > EXPERIMENT_CHUNK || off[col] > off[col+1] || k->offset + off[col+1] > e->size
+		|| decode(e->map + k->offset + off[col], e->map + k->offset + off[col+1], k->rows, out) < 0){
+		printf("ERROR: corrupted chunk %u column %s in experiment\n", chunk, e->column[col].name);
+		return -1;
+	}
+	return k->rows;
+}
+
+/** ****************************************************************
+ * Decode a chunk column
+ *
+ * @param e reader
+ * @param chunk chunk index
+ * @param col column index
+ * @param out values, EXPERIMENT_CHUNK doubles
+ * @brief function that decode one column of one chunk as doubles
+ * @return number of rows, -1 if error
+***************************************************************** */
+long experiment_decode(const experiment_t *e, uint32_t chunk, int col, double *out){
+	int64_t raw[EXPERIMENT_CHUNK];
+	uint32_t u32;
+	float f;
+	long i, n = decode_raw(e, chunk, col, raw);
+	for(i=0; i<n; i++){
+		switch(e->column[col].type){
+			case EXPERIMENT_U64:
+				out[i] = (double)(uint64_t)raw[i];
+				break;
+			case EXPERIMENT_F32:
+				u32 = (uint32_t)raw[i];
+				memcpy(&f, &u32, sizeof(f));
+				out[i] = f;
+				break;
+			default:
+				out[i] = (double)raw[i];
+		}
+	}
+	return n;
+}
+
+/** ****************************************************************
+ * Decode an integer chunk column
+ *
+ * @param e reader
+ * @param chunk chunk index
+ * @param col column index, not a float column
+ * @param out values, EXPERIMENT_CHUNK integers
+ * @brief function that decode one column of one chunk as exact integers (timestamps, ticks)
+ * @return number of rows, -1 if error
+***************************************************************** */
+long experiment_decode_int(const experiment_t *e, uint32_t chunk, int col, int64_t *out){
+	if(col >= 0 && (uint32_t)col < e->columns && e->column[col].type == EXPERIMENT_F32){
+		printf("ERROR: experiment column %s is not an integer column\n", e->column[col].name);
+		return -1;
+	}
+	return decode_raw(e, chunk, col, out);
+}
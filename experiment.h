@@ -0,0 +1,177 @@
+/** ****************************************************************
+ * @file experiment.h
+ * @brief Columnar experiment files for offline analysis.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * Telemetry runs of many robots and simulated episodes are packed in one
+ * experiment file. Each signal of the telemetry record is a column, rows
+ * are cut in chunks of EXPERIMENT_CHUNK ticks of a single run and every
+ * column of a chunk is compressed on its own. A footer indexes columns,
+ * runs and chunks (time range, tick range, column offsets), so a reader
+ * maps the file and decodes only the chunks and columns of a query.
+ * This header does not depend on libkhepera, it is used by host tools.
+ *
+ * File layout: header, chunk data, padding to 8 bytes, footer (runs,
+ * chunks, column offsets of chunks, columns), trailer. Integers are
+ * little endian.
+***************************************************************** */
+#ifndef EXPERIMENT_H
+#define EXPERIMENT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "telemetry.h"
+
+#define EXPERIMENT_MAGIC 0x4c4f434b ///< "KCOL" in little endian
+#define EXPERIMENT_VERSION 1 ///< version of file layout
+#define EXPERIMENT_CHUNK 4096 ///< biggest number of rows in a chunk
+#define EXPERIMENT_NAME 48 ///< size of column and run names, NUL included
+#define EXPERIMENT_COLUMNS 128 ///< biggest number of columns
+
+/** ****************************************************************
+ * Column types
+ *
+ * @brief type of a column in telemetry records
+***************************************************************** */
+enum {
+	EXPERIMENT_U64, ///< uint64_t
+	EXPERIMENT_U32, ///< uint32_t
+	EXPERIMENT_I32, ///< int32_t
+	EXPERIMENT_U16, ///< uint16_t
+	EXPERIMENT_I16, ///< int16_t
+	EXPERIMENT_F32 ///< float
+};
+
+/** ****************************************************************
+ * Column codecs
+ *
+ * @brief encoding of a column chunk, the writer keeps the smallest
+ * @note values are zigzag varints, a 0 is followed by the varint count of following 0s
+***************************************************************** */
+enum {
+	EXPERIMENT_DELTA, ///< difference with previous value (slow signals, constants)
+	EXPERIMENT_DELTA2 ///< difference with previous difference (clocks, counters, ramps)
+};
+
+/** ****************************************************************
+ * Experiment file header
+ *
+ * @brief header written at the beginning of an experiment file
+***************************************************************** */
+typedef struct {
+	uint32_t magic; ///< EXPERIMENT_MAGIC
+	uint16_t version; ///< EXPERIMENT_VERSION
+	uint16_t telemetry_version; ///< TELEMETRY_VERSION of packed records
+} experiment_header_t;
+
+/** ****************************************************************
+ * Column description
+ *
+ * @brief name and type of a column, in footer
+ * @note floats are stored as their bit pattern, so values are bit exact
+***************************************************************** */
+typedef struct {
+	char name[EXPERIMENT_NAME]; ///< column name, same as telemetry_decode CSV columns
+	uint16_t type; ///< column type
+	uint16_t offset; ///< offset of the value in telemetry_record_t (in bytes)
+} experiment_column_t;
+
+/** ****************************************************************
+ * Run description
+ *
+ * @brief a run of a telemetry file, in footer
+***************************************************************** */
+typedef struct {
+	char name[EXPERIMENT_NAME]; ///< telemetry file and run number in file
+	uint64_t first_ns; ///< time of first row (robot monotonic clock, in ns)
+	uint64_t last_ns; ///< time of last row (robot monotonic clock, in ns)
+	uint64_t rows; ///< number of rows
+	uint32_t first_chunk; ///< index of first chunk of run
+	uint32_t chunks; ///< number of chunks of run
+} experiment_run_t;
+
+/** ****************************************************************
+ * Chunk description
+ *
+ * @brief rows of a run stored together, in footer
+ * @note column c of chunk k is at offset + offsets[k*(columns+1) + c] of the file,
+ * its size is offsets[k*(columns+1) + c + 1] - offsets[k*(columns+1) + c]
+***************************************************************** */
+typedef struct {
+	uint64_t offset; ///< file offset of chunk data
+	uint64_t first_ns; ///< time of first row (in ns)
+	uint64_t last_ns; ///< time of last row (in ns)
+	uint32_t first_tick; ///< tick of first row
+	uint32_t last_tick; ///< tick of last row
+	uint32_t run; ///< run of chunk
+	uint32_t rows; ///< number of rows
+} experiment_chunk_t;
+
+/** ****************************************************************
+ * Experiment file trailer
+ *
+ * @brief last bytes of an experiment file, locate the footer
+***************************************************************** */
+typedef struct {
+	uint64_t footer; ///< file offset of footer
+	uint32_t columns; ///< number of columns
+	uint32_t runs; ///< number of runs
+	uint32_t chunks; ///< number of chunks
+	uint32_t magic; ///< EXPERIMENT_MAGIC
+} experiment_trailer_t;
+
+/** ****************************************************************
+ * Experiment file writer
+ *
+ * @brief state of an experiment file being packed
+***************************************************************** */
+typedef struct {
+	FILE *file; ///< experiment file
+	uint64_t pos; ///< file offset of next chunk
+	experiment_column_t column[EXPERIMENT_COLUMNS]; ///< columns of telemetry records
+	uint32_t columns; ///< number of columns
+	experiment_run_t *run; ///< runs written
+	uint32_t runs; ///< number of runs
+	experiment_chunk_t *chunk; ///< chunks written
+	uint32_t *offsets; ///< column offsets of chunks written
+	uint32_t chunks; ///< number of chunks
+	uint32_t cap; ///< capacity of chunk tables
+	int64_t *raw; ///< values of pending rows, EXPERIMENT_CHUNK per column
+	unsigned char *buf; ///< encoded column of pending chunk
+	uint32_t rows; ///< number of pending rows
+	uint64_t bytes_in; ///< size of records packed (in bytes)
+} experiment_writer_t;
+
+/** ****************************************************************
+ * Experiment file reader
+ *
+ * @brief experiment file mapped in memory
+***************************************************************** */
+typedef struct {
+	const unsigned char *map; ///< mapped file
+	size_t size; ///< file size (in bytes)
+	const experiment_column_t *column; ///< columns
+	const experiment_run_t *run; ///< runs
+	const experiment_chunk_t *chunk; ///< chunks
+	const uint32_t *offsets; ///< column offsets of chunks
+	uint32_t columns; ///< number of columns
+	uint32_t runs; ///< number of runs
+	uint32_t chunks; ///< number of chunks
+} experiment_t;
+
+int experiment_create(experiment_writer_t *w, const char *path);
+int experiment_begin_run(experiment_writer_t *w, const char *name);
+int experiment_append(experiment_writer_t *w, const telemetry_record_t *r);
+int experiment_finish(experiment_writer_t *w);
+
+int experiment_open(experiment_t *e, const char *path);
+int experiment_close(experiment_t *e);
+int experiment_find(const experiment_t *e, const char *name);
+int experiment_overlaps(const experiment_t *e, uint32_t chunk, uint64_t from_ns, uint64_t to_ns);
+long experiment_decode(const experiment_t *e, uint32_t chunk, int col, double *out);
+long experiment_decode_int(const experiment_t *e, uint32_t chunk, int col, int64_t *out);
+
+#endif
@@ -0,0 +1,57 @@
+/** ****************************************************************
+ * @file fleet.h
+ * @brief Protocol between the fleet coordinator and the robot agents.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * The coordinator (tools/fleet) connects to the agent of every robot
+ * (./model -g) over TCP, estimates robot clock offsets, pushes model
+ * options and starts all robots at the same instant. Agents report
+ * behaviour switches, damage, death and a periodic status stamped with the robot monotonic
+ * clock, the coordinator maps them back on its own clock.
+ * This header does not depend on libkhepera, it is shared with host tools.
+***************************************************************** */
+#ifndef FLEET_H
+#define FLEET_H
+
+#include <stdint.h>
+
+#define FLEET_PORT 5600 ///< default TCP port of robot agents
+#define FLEET_VERSION 2 ///< protocol version
+#define FLEET_ARGS 224 ///< biggest model options payload of FLEET_CONFIG (in bytes)
+
+/** ****************************************************************
+ * Message types
+ *
+ * @brief coordinator requests and agent reports
+***************************************************************** */
+enum {
+	FLEET_HELLO = 1, ///< agent greeting, a = FLEET_VERSION
+	FLEET_SYNC, ///< clock probe, t_ns = coordinator send time, answered with t2_ns = robot receive time and t3_ns = robot send time
+	FLEET_CONFIG, ///< model options, followed by size - sizeof(fleet_msg_t) bytes of NUL separated arguments
+	FLEET_START, ///< start model, t2_ns = start time on robot clock
+	FLEET_STARTED, ///< model started, t_ns = robot start time
+	FLEET_SWITCH, ///< behaviour switch, a = previous behaviour, b = new behaviour
+	FLEET_DAMAGE, ///< damage applied, a = integrity loss (in 1/1000000)
+	FLEET_DEATH, ///< model stopped, a = need whose variable reached 0 (-1 if alive)
+	FLEET_STATUS ///< periodic model state, a = behaviour, b = lowest physiological variable (in 1/1000000)
+};
+
+/** ****************************************************************
+ * Fleet message
+ *
+ * @brief fixed header of every message, in host byte order (robots and host are little endian)
+***************************************************************** */
+typedef struct {
+	uint16_t type; ///< message type
+	uint16_t size; ///< message size, header included (in bytes)
+	uint32_t tick; ///< model tick of event, 0 for control messages
+	uint64_t t_ns; ///< event time on sender monotonic clock (in ns)
+	uint64_t t2_ns; ///< second timestamp, see message types
+	uint64_t t3_ns; ///< third timestamp, see message types
+	int32_t a; ///< first argument
+	int32_t b; ///< second argument
+} fleet_msg_t;
+
+#endif
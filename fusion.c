@@ -0,0 +1,42 @@
+/** ****************************************************************
+ * @file fusion.c
+ * @brief Fusion of ground and ultrasound sensors into a perception.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * Resources are detected by a vote of ground channels, so a single
+ * channel on the edge of a patch or on a floor mark is not enough.
+***************************************************************** */
+#include "fusion.h"
+
+/** ****************************************************************
+ * Update perception
+ *
+ * @param p perception to update
+ * @param f actual acquisition frame
+ * @brief function that detect resources with ground sensors and nearest obstacle with ultrasounds
+ * @return 0 when ok
+***************************************************************** */
+int fusion_update(perception_t *p, const ir_frame_t *f){
+	int i, sum = 0, dark = 0, bright = 0;
+	for(i=0; i<GROUND_CHANNELS; i++){
+		sum += f->ground[i];
+		dark += f->ground[i] < FUSION_FOOD_MAX;
+		bright += f->ground[i] > FUSION_GROOM_MIN;
+	}
+	p->ground_mean = sum / GROUND_CHANNELS;
+	p->food = dark >= FUSION_GROUND_VOTES;
+	p->grooming = bright >= FUSION_GROUND_VOTES;
+	p->us_min = ACQ_US_NONE;
+	p->us_channel = -1;
+	if(f->us_t_ns == 0 || f->us_t_ns + FUSION_US_MAX_AGE < f->t_ns)
+		return 0;
+	for(i=0; i<HAL_US_CHANNELS; i++){
+		if(f->us[i] < p->us_min){
+			p->us_min = f->us[i];
+			p->us_channel = i;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,38 @@
+/** ****************************************************************
+ * @file fusion.h
+ * @brief Fusion of ground and ultrasound sensors into a perception.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * Ground sensors see resources on the floor (dark food patches, bright
+ * grooming spots), ultrasounds give the nearest obstacle at long range.
+ * Values come from the fused acquisition frame, no extra bus reading.
+***************************************************************** */
+#ifndef FUSION_H
+#define FUSION_H
+
+#include <stdint.h>
+#include "acquisition.h"
+
+#define FUSION_FOOD_MAX 400 ///< ground value under which floor is a food patch
+#define FUSION_GROOM_MIN 950 ///< ground value above which floor is a grooming spot
+#define FUSION_GROUND_VOTES 2 ///< ground channels that must agree to detect a resource
+#define FUSION_US_MAX_AGE 500000000ULL ///< ultrasound values older than this are ignored (in ns)
+
+/** ****************************************************************
+ * Perception
+ *
+ * @brief fused perception of the actual frame
+***************************************************************** */
+typedef struct {
+	int ground_mean; ///< mean of ground channels
+	int food; ///< 1 when robot is on a food patch
+	int grooming; ///< 1 when robot is on a grooming spot
+	int us_min; ///< nearest ultrasound distance (in cm), ACQ_US_NONE if nothing or too old
+	int us_channel; ///< ultrasound channel of us_min, -1 if none
+} perception_t;
+
+int fusion_update(perception_t *p, const ir_frame_t *f);
+
+#endif
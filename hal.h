@@ -0,0 +1,43 @@
+/** ****************************************************************
+ * @file hal.h
+ * @brief Hardware abstraction layer for Khepera IV.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * Every access to the robot (sensors, motors, leds, battery, clock) goes
+ * through this interface. Two backends implement it: hal_khepera.c on the
+ * robot with libkhepera, and hal_sim.c, a simulated 2D arena used by the
+ * host build (make host).
+***************************************************************** */
+#ifndef HAL_H
+#define HAL_H
+
+#include <stdint.h>
+
+#define HAL_MODE_IDLE 0 ///< motor controller idle mode
+#define HAL_MODE_SPEED 1 ///< motor controller speed regulation mode
+
+#define HAL_IR_CHANNELS 12 ///< proximity channels returned by hal_proximity_ir() (8 IR + 4 ground)
+#define HAL_US_CHANNELS 5 ///< ultrasound channels returned by hal_measure_us()
+#define HAL_US_ALL 31 ///< mask of all ultrasound channels for hal_activate_us()
+
+typedef struct hal_dev hal_dev_t; ///< robot device, defined by backend
+
+hal_dev_t *hal_open(int argc, char *argv[]);
+int hal_close(hal_dev_t *dev);
+int hal_is_simulated(void);
+
+int hal_proximity_ir(hal_dev_t *dev, char *buf);
+int hal_measure_us(hal_dev_t *dev, char *buf);
+int hal_activate_us(hal_dev_t *dev, int mask);
+int hal_set_mode(hal_dev_t *dev, int mode);
+int hal_set_speed(hal_dev_t *dev, int left, int right);
+int hal_set_leds(hal_dev_t *dev, int lr, int lg, int lb, int rr, int rg, int rb, int br, int bg, int bb);
+int hal_battery_status(hal_dev_t *dev, char *buf);
+int hal_battery_charge(hal_dev_t *dev);
+
+uint64_t hal_now_ns(hal_dev_t *dev);
+int hal_sleep_until(hal_dev_t *dev, uint64_t t_ns);
+
+#endif
@@ -0,0 +1,186 @@
+/** ****************************************************************
+ * @file hal_khepera.c
+ * @brief Hardware abstraction layer, libkhepera backend.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * Real robot backend, every call is forwarded to the dsPic through
+ * libkhepera. Clock is the monotonic clock of the robot.
+***************************************************************** */
+#include "hal.h"
+#include <khepera/khepera.h>
+#include <errno.h>
+#include <stdio.h>
+#include <time.h>
+
+/** ****************************************************************
+ * Robot device
+ *
+ * @brief libkhepera handle of the robot
+***************************************************************** */
+struct hal_dev {
+	knet_dev_t *dsPic; ///< robot pic microcontroller access
+};
+
+/** ****************************************************************
+ * Open robot
+ *
+ * @param argc number of program arguments
+ * @param argv program arguments, given to kb_init()
+ * @brief function that init libkhepera and open K-Net device
+ * @return robot device, NULL if error
+***************************************************************** */
+hal_dev_t *hal_open(int argc, char *argv[]){
+	static hal_dev_t dev;
+
+	// Set the libkhepera debug level - recommended for development.
+	kb_set_debug_level(2);
+
+	// Init the Khepera library
+	if(kb_init(argc, argv) < 0)
+	{
+		printf("ERROR: kb_init error (no privs? try sudo)\n");
+		return NULL;
+	}
+
+	// open K-Net device and store the handle
+	dev.dsPic = knet_open("Khepera4:dsPic", KNET_BUS_I2C, 0, NULL);
+	if (dev.dsPic==NULL)
+	{
+		printf("ERROR: could not initiate comms with Kh4 dsPic\n");
+		return NULL;
+	}
+	return &dev;
+}
+
+/** ****************************************************************
+ * Close robot
+ *
+ * @param dev robot device
+ * @brief function that close K-Net device
+ * @return 0 when ok
+***************************************************************** */
+int hal_close(hal_dev_t *dev){
+	knet_close(dev->dsPic);
+	return 0;
+}
+
+/** ****************************************************************
+ * Backend type
+ *
+ * @brief function that tell if backend is simulated
+ * @return 0, real robot
+***************************************************************** */
+int hal_is_simulated(void){
+	return 0;
+}
+
+/** ****************************************************************
+ * Read proximity sensors, 12 little endian values
+ *
+ * @brief function that read proximity sensors, 12 little endian values
+ * @return libkhepera result, <0 if error
+***************************************************************** */
+int hal_proximity_ir(hal_dev_t *dev, char *buf){
+	return kh4_proximity_ir(buf, dev->dsPic);
+}
+
+/** ****************************************************************
+ * Read ultrasound sensors, 5 little endian values
+ *
+ * @brief function that read ultrasound sensors, 5 little endian values
+ * @return libkhepera result, <0 if error
+***************************************************************** */
+int hal_measure_us(hal_dev_t *dev, char *buf){
+	return kh4_measure_us(buf, dev->dsPic);
+}
+
+/** ****************************************************************
+ * Activate ultrasound sensors of mask
+ *
+ * @brief function that activate ultrasound sensors of mask
+ * @return libkhepera result, <0 if error
+***************************************************************** */
+int hal_activate_us(hal_dev_t *dev, int mask){
+	return kh4_activate_us(mask, dev->dsPic);
+}
+
+/** ****************************************************************
+ * Set motor controller mode (HAL_MODE_IDLE or HAL_MODE_SPEED)
+ *
+ * @brief function that set motor controller mode (HAL_MODE_IDLE or HAL_MODE_SPEED)
+ * @return libkhepera result, <0 if error
+***************************************************************** */
+int hal_set_mode(hal_dev_t *dev, int mode){
+	return kh4_SetMode(mode == HAL_MODE_SPEED ? kh4RegSpeed : kh4RegIdle, dev->dsPic);
+}
+
+/** ****************************************************************
+ * Set wheel speeds
+ *
+ * @brief function that set wheel speeds
+ * @return libkhepera result, <0 if error
+***************************************************************** */
+int hal_set_speed(hal_dev_t *dev, int left, int right){
+	return kh4_set_speed(left, right, dev->dsPic);
+}
+
+/** ****************************************************************
+ * Set rgb color of left, right and back leds
+ *
+ * @brief function that set rgb color of left, right and back leds
+ * @return libkhepera result, <0 if error
+***************************************************************** */
+int hal_set_leds(hal_dev_t *dev, int lr, int lg, int lb, int rr, int rg, int rb, int br, int bg, int bb){
+	return kh4_SetRGBLeds(lr, lg, lb, rr, rg, rb, br, bg, bb, dev->dsPic);
+}
+
+/** ****************************************************************
+ * Read battery status, 12 bytes
+ *
+ * @brief function that read battery status, 12 bytes
+ * @return libkhepera result, <0 if error
+***************************************************************** */
+int hal_battery_status(hal_dev_t *dev, char *buf){
+	return kh4_battery_status(buf, dev->dsPic);
+}
+
+/** ****************************************************************
+ * Tell if charger is plugged
+ *
+ * @brief function that tell if charger is plugged
+ * @return libkhepera result, <0 if error
+***************************************************************** */
+int hal_battery_charge(hal_dev_t *dev){
+	return kh4_battery_charge(dev->dsPic);
+}
+
+/** ****************************************************************
+ * Read clock
+ *
+ * @param dev robot device, unused
+ * @brief function that read monotonic clock
+ * @return monotonic time in ns
+***************************************************************** */
+uint64_t hal_now_ns(hal_dev_t *dev){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec*1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/** ****************************************************************
+ * Sleep until absolute time
+ *
+ * @param dev robot device, unused
+ * @param t_ns absolute wakeup time in ns
+ * @brief function that sleep until an absolute monotonic deadline
+ * @return 0 when ok
+***************************************************************** */
+int hal_sleep_until(hal_dev_t *dev, uint64_t t_ns){
+	struct timespec ts;
+	ts.tv_sec = t_ns / 1000000000ULL;
+	ts.tv_nsec = t_ns % 1000000000ULL;
+	while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR);
+	return 0;
+}
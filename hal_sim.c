@@ -0,0 +1,530 @@
+/** ****************************************************************
+ * @file hal_sim.c
+ * @brief Hardware abstraction layer, simulated backend.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * Simulated Khepera IV in a 2D arena: differential drive kinematics,
+ * IR proximity sensors and ultrasounds by ray casting on walls and round
+ * obstacles. Time is virtual, it only moves forward in hal_sleep_until(),
+ * so the model loop runs as fast as the host CPU allows.
+***************************************************************** */
+#include "hal_sim.h"
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SIM_ROBOT_RADIUS 70.0 ///< robot radius (in mm)
+#define SIM_WHEEL_BASE 105.4 ///< distance between wheels (in mm)
+#define SIM_SPEED_UNIT 0.678181 ///< wheel speed of one speed unit (in mm/s)
+#define SIM_IR_DECAY 35.0 ///< distance for IR value to drop by e (in mm)
+#define SIM_IR_RANGE 250.0 ///< maximum IR detection distance (in mm)
+#define SIM_IR_NOISE 4 ///< amplitude of IR noise
+#define SIM_FLOOR 800 ///< ground sensor value on arena floor
+#define SIM_US_MIN 250.0 ///< minimum ultrasound distance (in mm)
+#define SIM_US_MAX 2000.0 ///< maximum ultrasound distance (in mm)
+#define SIM_US_NONE 1000 ///< ultrasound value when nothing is detected
+#define SIM_STEP_NS 5000000ULL ///< physics integration step (in ns)
+#define SIM_MAX_OBSTACLES 16 ///< maximum number of round obstacles
+#define SIM_MAX_PATCHES 8 ///< maximum number of floor patches
+#define SIM_GROUND_OFFSET 50.0 ///< distance of ground sensors from robot center (in mm)
+#define SIM_FOOD 200 ///< ground sensor value on a food patch
+#define SIM_GROOM 1000 ///< ground sensor value on a grooming spot
+
+static const double ir_angles[8] = {
+	3*M_PI/4, M_PI/2, M_PI/4, 0.0, -M_PI/4, -M_PI/2, -3*M_PI/4, M_PI
+}; ///< IR sensor directions from robot heading (back left, left, front left, front, front right, right, back right, back)
+
+static const double us_angles[HAL_US_CHANNELS] = {
+	M_PI/2, M_PI/4, 0.0, -M_PI/4, -M_PI/2
+}; ///< ultrasound directions from robot heading (left, front left, front, front right, right)
+
+static const double ground_angles[4] = {
+	M_PI/6, M_PI/18, -M_PI/18, -M_PI/6
+}; ///< ground sensor directions from robot heading (left, front left, front right, right)
+
+/** ****************************************************************
+ * Round obstacle
+ *
+ * @brief obstacle of the arena
+***************************************************************** */
+typedef struct {
+	double x; ///< center x (in mm)
+	double y; ///< center y (in mm)
+	double r; ///< radius (in mm)
+} sim_obstacle_t;
+
+/** ****************************************************************
+ * Floor patch
+ *
+ * @brief round patch of the floor seen by ground sensors (food, grooming spot)
+***************************************************************** */
+typedef struct {
+	double x; ///< center x (in mm)
+	double y; ///< center y (in mm)
+	double r; ///< radius (in mm)
+	int value; ///< ground sensor value on the patch
+} sim_patch_t;
+
+/** ****************************************************************
+ * Robot device
+ *
+ * @brief simulated robot and its arena
+***************************************************************** */
+struct hal_dev {
+	uint64_t t_ns; ///< virtual time (in ns)
+	double x; ///< robot x position (in mm)
+	double y; ///< robot y position (in mm)
+	double theta; ///< robot heading (in rad)
+	int mode; ///< motor controller mode
+	int left; ///< left wheel speed command
+	int right; ///< right wheel speed command
+	int us_mask; ///< active ultrasounds
+	double width; ///< arena width (in mm)
+	double height; ///< arena height (in mm)
+	int n_obstacles; ///< number of obstacles
+	sim_obstacle_t obstacles[SIM_MAX_OBSTACLES]; ///< round obstacles
+	int n_patches; ///< number of floor patches
+	sim_patch_t patches[SIM_MAX_PATCHES]; ///< floor patches
+	unsigned int seed; ///< noise generator state
+	double battery; ///< battery charge in [0,1]
+	unsigned long collisions; ///< physics steps blocked by a collision
+};
+
+/** ****************************************************************
+ * Uniform noise
+ *
+ * @param dev robot device
+ * @param amplitude noise amplitude
+ * @brief function that draw an integer noise in [-amplitude, amplitude]
+ * @return noise
+***************************************************************** */
+static int sim_noise(hal_dev_t *dev, int amplitude){
+	return (rand_r(&dev->seed) % (2*amplitude+1)) - amplitude;
+}
+
+/** ****************************************************************
+ * Cast a ray
+ *
+ * @param dev robot device
+ * @param px ray origin x (in mm)
+ * @param py ray origin y (in mm)
+ * @param a ray direction (in rad)
+ * @brief function that compute distance to nearest wall or obstacle
+ * @return distance (in mm)
+***************************************************************** */
+static double sim_ray(const hal_dev_t *dev, double px, double py, double a){
+	double dx = cos(a), dy = sin(a), t, best = INFINITY;
+	double b, c, disc;
+	int i;
+	if(dx > 1e-9 && (t = (dev->width - px)/dx) < best) best = t;
+	if(dx < -1e-9 && (t = -px/dx) < best) best = t;
+	if(dy > 1e-9 && (t = (dev->height - py)/dy) < best) best = t;
+	if(dy < -1e-9 && (t = -py/dy) < best) best = t;
+	for(i=0; i<dev->n_obstacles; i++){
+		const sim_obstacle_t *o = &dev->obstacles[i];
+		b = dx*(px - o->x) + dy*(py - o->y);
+		c = (px - o->x)*(px - o->x) + (py - o->y)*(py - o->y) - o->r*o->r;
+		disc = b*b - c;
+		if(disc < 0)
+			continue;
+		t = -b - sqrt(disc);
+		if(t < 0)
+			t = 0; // sensor touch the obstacle
+		if(-b + sqrt(disc) >= 0 && t < best)
+			best = t;
+	}
+	return best < 0 ? 0 : best;
+}
+
+/** ****************************************************************
+ * Check collision
+ *
+ * @param dev robot device
+ * @param x robot x position (in mm)
+ * @param y robot y position (in mm)
+ * @brief function that check if robot body overlap a wall or an obstacle
+ * @return 1 if collision, 0 otherwise
+***************************************************************** */
+static int sim_collides(const hal_dev_t *dev, double x, double y){
+	int i;
+	if(x < SIM_ROBOT_RADIUS || y < SIM_ROBOT_RADIUS || x > dev->width - SIM_ROBOT_RADIUS || y > dev->height - SIM_ROBOT_RADIUS)
+		return 1;
+	for(i=0; i<dev->n_obstacles; i++){
+		const sim_obstacle_t *o = &dev->obstacles[i];
+		double d = SIM_ROBOT_RADIUS + o->r;
+		if((x - o->x)*(x - o->x) + (y - o->y)*(y - o->y) < d*d)
+			return 1;
+	}
+	return 0;
+}
+
+/** ****************************************************************
+ * Read floor
+ *
+ * @param dev robot device
+ * @param a ground sensor direction from robot heading (in rad)
+ * @brief function that give ground value under a ground sensor
+ * @return value of the patch under the sensor, SIM_FLOOR if none
+***************************************************************** */
+static int sim_floor(const hal_dev_t *dev, double a){
+	double x = dev->x + SIM_GROUND_OFFSET*cos(dev->theta + a);
+	double y = dev->y + SIM_GROUND_OFFSET*sin(dev->theta + a);
+	int i;
+	for(i=0; i<dev->n_patches; i++){
+		const sim_patch_t *p = &dev->patches[i];
+		if((x - p->x)*(x - p->x) + (y - p->y)*(y - p->y) < p->r*p->r)
+			return p->value;
+	}
+	return SIM_FLOOR;
+}
+
+/** ****************************************************************
+ * Integrate robot motion
+ *
+ * @param dev robot device
+ * @param dt_ns integration time (in ns)
+ * @brief function that move robot with differential drive kinematics
+ * @return 0 when ok
+ * @note a move that would overlap an obstacle is blocked, rotation is kept
+***************************************************************** */
+static int sim_step(hal_dev_t *dev, uint64_t dt_ns){
+	double dt = dt_ns/1e9, vl, vr, v, w, nx, ny;
+	if(dev->mode == HAL_MODE_SPEED){
+		vl = dev->left*SIM_SPEED_UNIT;
+		vr = dev->right*SIM_SPEED_UNIT;
+	}
+	else{
+		vl = 0.0;
+		vr = 0.0;
+	}
+	v = (vl + vr)/2.0;
+	w = (vr - vl)/SIM_WHEEL_BASE;
+	nx = dev->x + v*cos(dev->theta)*dt;
+	ny = dev->y + v*sin(dev->theta)*dt;
+	if(!sim_collides(dev, nx, ny)){
+		dev->x = nx;
+		dev->y = ny;
+	}
+	else if(v != 0.0)
+		dev->collisions++;
+	dev->theta = remainder(dev->theta + w*dt, 2*M_PI);
+	dev->battery -= dt*(1.2e-3 + 1e-6*(fabs(vl) + fabs(vr))); // about 14 min idle, 11 min at speed 200
+	if(dev->battery < 0)
+		dev->battery = 0;
+	return 0;
+}
+
+/** ****************************************************************
+ * Uniform draw
+ *
+ * @param seed generator state
+ * @param min lower bound
+ * @param max upper bound
+ * @brief function that draw a real in [min, max]
+ * @return drawn value
+***************************************************************** */
+static double sim_uniform(unsigned int *seed, double min, double max){
+	return min + (max - min)*((double)rand_r(seed)/RAND_MAX);
+}
+
+/** ****************************************************************
+ * Open simulated robot
+ *
+ * @param seed arena seed, 0 for default arena
+ * @brief function that create simulated robot in default or random arena
+ * @return robot device, NULL if error
+ * @note default arena is a 1 m square with two round obstacles, a random
+ * arena has random size, obstacles and start pose drawn from seed
+***************************************************************** */
+hal_dev_t *hal_sim_open(unsigned int seed){
+	int i, tries;
+	hal_dev_t *dev = calloc(1, sizeof(hal_dev_t));
+	if(dev == NULL){
+		printf("ERROR: could not allocate simulated robot\n");
+		return NULL;
+	}
+	dev->mode = HAL_MODE_IDLE;
+	dev->us_mask = 31;
+	dev->battery = 1.0;
+	if(seed == 0){
+		dev->width = 1000.0;
+		dev->height = 1000.0;
+		dev->n_obstacles = 2;
+		dev->obstacles[0].x = 250.0; dev->obstacles[0].y = 250.0; dev->obstacles[0].r = 60.0;
+		dev->obstacles[1].x = 750.0; dev->obstacles[1].y = 700.0; dev->obstacles[1].r = 80.0;
+		dev->n_patches = 2;
+		dev->patches[0].x = 500.0; dev->patches[0].y = 200.0; dev->patches[0].r = 80.0; dev->patches[0].value = SIM_FOOD;
+		dev->patches[1].x = 200.0; dev->patches[1].y = 750.0; dev->patches[1].r = 70.0; dev->patches[1].value = SIM_GROOM;
+		dev->x = 500.0;
+		dev->y = 500.0;
+		dev->theta = 0.0;
+		dev->seed = 1;
+		return dev;
+	}
+	dev->width = sim_uniform(&seed, 800.0, 1500.0);
+	dev->height = sim_uniform(&seed, 800.0, 1500.0);
+	dev->n_obstacles = 1 + rand_r(&seed) % 6;
+	for(i=0; i<dev->n_obstacles; i++){
+		dev->obstacles[i].r = sim_uniform(&seed, 40.0, 100.0);
+		dev->obstacles[i].x = sim_uniform(&seed, 0.0, dev->width);
+		dev->obstacles[i].y = sim_uniform(&seed, 0.0, dev->height);
+	}
+	// start pose is drawn until robot is clear of walls and obstacles
+	for(tries=0; tries<1000; tries++){
+		dev->x = sim_uniform(&seed, SIM_ROBOT_RADIUS, dev->width - SIM_ROBOT_RADIUS);
+		dev->y = sim_uniform(&seed, SIM_ROBOT_RADIUS, dev->height - SIM_ROBOT_RADIUS);
+		if(!sim_collides(dev, dev->x, dev->y))
+			break;
+	}
+	if(tries == 1000)
+		dev->n_obstacles = 0; // arena too crowded, keep it empty
+	dev->theta = sim_uniform(&seed, -M_PI, M_PI);
+	dev->seed = seed;
+	// patches are drawn last from their own copy of seed, arena and noise do not depend on them
+	dev->n_patches = 2;
+	for(i=0; i<dev->n_patches; i++){
+		dev->patches[i].r = sim_uniform(&seed, 60.0, 120.0);
+		dev->patches[i].x = sim_uniform(&seed, 0.0, dev->width);
+		dev->patches[i].y = sim_uniform(&seed, 0.0, dev->height);
+		dev->patches[i].value = i == 0 ? SIM_FOOD : SIM_GROOM;
+	}
+	return dev;
+}
+
+/** ****************************************************************
+ * Get simulation stats
+ *
+ * @param dev robot device
+ * @brief function that give the number of physics steps blocked by a collision
+ * @return number of blocked steps
+***************************************************************** */
+unsigned long hal_sim_collisions(const hal_dev_t *dev){
+	return dev->collisions;
+}
+
+/** ****************************************************************
+ * Destroy simulated robot
+ *
+ * @param dev robot device
+ * @brief function that free simulated robot without printing stats
+ * @return 0 when ok
+***************************************************************** */
+int hal_sim_destroy(hal_dev_t *dev){
+	free(dev);
+	return 0;
+}
+
+/** ****************************************************************
+ * Open robot
+ *
+ * @param argc number of program arguments, unused
+ * @param argv program arguments, unused
+ * @brief function that create simulated robot in default arena
+ * @return robot device, NULL if error
+***************************************************************** */
+hal_dev_t *hal_open(int argc, char *argv[]){
+	return hal_sim_open(0);
+}
+
+/** ****************************************************************
+ * Close robot
+ *
+ * @param dev robot device
+ * @brief function that free simulated robot
+ * @return 0 when ok
+***************************************************************** */
+int hal_close(hal_dev_t *dev){
+	printf("Simulation: %.1f s simulated | robot at (%.0f, %.0f) mm | %lu blocked steps\n",
+		dev->t_ns/1e9, dev->x, dev->y, dev->collisions);
+	return hal_sim_destroy(dev);
+}
+
+/** ****************************************************************
+ * Backend type
+ *
+ * @brief function that tell if backend is simulated
+ * @return 1, simulated robot
+***************************************************************** */
+int hal_is_simulated(void){
+	return 1;
+}
+
+/** ****************************************************************
+ * Read proximity sensors
+ *
+ * @param dev robot device
+ * @param buf buffer for 12 little endian values (8 IR then 4 ground)
+ * @brief function that simulate proximity sensors
+ * @return 0 when ok
+***************************************************************** */
+int hal_proximity_ir(hal_dev_t *dev, char *buf){
+	int i, v;
+	double a, d;
+	for(i=0; i<HAL_IR_CHANNELS; i++){
+		if(i < 8){
+			a = dev->theta + ir_angles[i];
+			d = sim_ray(dev, dev->x + SIM_ROBOT_RADIUS*cos(a), dev->y + SIM_ROBOT_RADIUS*sin(a), a);
+			v = (d < SIM_IR_RANGE) ? (int)(1023.0*exp(-d/SIM_IR_DECAY)) : 0;
+			v += sim_noise(dev, SIM_IR_NOISE) + SIM_IR_NOISE;
+		}
+		else
+			v = sim_floor(dev, ground_angles[i-8]) + sim_noise(dev, SIM_IR_NOISE);
+		if(v < 0) v = 0;
+		if(v > 1023) v = 1023;
+		buf[i*2] = v & 0xff;
+		buf[i*2+1] = (v >> 8) & 0xff;
+	}
+	return 0;
+}
+
+/** ****************************************************************
+ * Read ultrasound sensors
+ *
+ * @param dev robot device
+ * @param buf buffer for 5 little endian distances (in cm)
+ * @brief function that simulate ultrasound sensors
+ * @return 0 when ok
+***************************************************************** */
+int hal_measure_us(hal_dev_t *dev, char *buf){
+	int i, v;
+	double a, d;
+	for(i=0; i<HAL_US_CHANNELS; i++){
+		a = dev->theta + us_angles[i];
+		d = sim_ray(dev, dev->x + SIM_ROBOT_RADIUS*cos(a), dev->y + SIM_ROBOT_RADIUS*sin(a), a);
+		if(!(dev->us_mask & (1 << i)) || d > SIM_US_MAX)
+			v = SIM_US_NONE;
+		else
+			v = (int)((d < SIM_US_MIN ? SIM_US_MIN : d)/10.0);
+		buf[i*2] = v & 0xff;
+		buf[i*2+1] = (v >> 8) & 0xff;
+	}
+	return 0;
+}
+
+/** ****************************************************************
+ * Activate ultrasound sensors
+ *
+ * @param dev robot device
+ * @param mask active sensors (bit i for sensor i)
+ * @brief function that activate ultrasound sensors of mask
+ * @return 0 when ok
+***************************************************************** */
+int hal_activate_us(hal_dev_t *dev, int mask){
+	dev->us_mask = mask;
+	return 0;
+}
+
+/** ****************************************************************
+ * Set motor controller mode
+ *
+ * @param dev robot device
+ * @param mode HAL_MODE_IDLE or HAL_MODE_SPEED
+ * @brief function that set motor controller mode
+ * @return 0 when ok
+***************************************************************** */
+int hal_set_mode(hal_dev_t *dev, int mode){
+	dev->mode = mode;
+	return 0;
+}
+
+/** ****************************************************************
+ * Set wheel speeds
+ *
+ * @param dev robot device
+ * @param left left wheel speed
+ * @param right right wheel speed
+ * @brief function that set wheel speeds
+ * @return 0 when ok
+***************************************************************** */
+int hal_set_speed(hal_dev_t *dev, int left, int right){
+	dev->left = left;
+	dev->right = right;
+	return 0;
+}
+
+/** ****************************************************************
+ * Set leds
+ *
+ * @brief function that set rgb color of the 3 leds, nothing to do in simulation
+ * @return 0 when ok
+***************************************************************** */
+int hal_set_leds(hal_dev_t *dev, int lr, int lg, int lb, int rr, int rg, int rb, int br, int bg, int bb){
+	return 0;
+}
+
+/** ****************************************************************
+ * Read battery status
+ *
+ * @param dev robot device
+ * @param buf buffer for 12 bytes with libkhepera layout
+ * @brief function that simulate battery status
+ * @return 0 when ok
+***************************************************************** */
+int hal_battery_status(hal_dev_t *dev, char *buf){
+	short current = (short)((150.0 + 0.25*(abs(dev->left) + abs(dev->right)))/0.07813);
+	short temperature = (short)(25.0/0.003906);
+	short voltage = (short)((3500.0 + 700.0*dev->battery)/9.76);
+	memset(buf, 0, 12);
+	buf[3] = (char)(dev->battery*100.0);
+	memcpy(buf+4, &current, sizeof(short));
+	memcpy(buf+8, &temperature, sizeof(short));
+	memcpy(buf+10, &voltage, sizeof(short));
+	return 0;
+}
+
+/** ****************************************************************
+ * Charger status
+ *
+ * @brief function that tell if charger is plugged
+ * @return 0, never plugged in simulation
+***************************************************************** */
+int hal_battery_charge(hal_dev_t *dev){
+	return 0;
+}
+
+/** ****************************************************************
+ * Read clock
+ *
+ * @param dev robot device, NULL for host monotonic clock
+ * @brief function that read virtual time of simulation
+ * @return time in ns
+***************************************************************** */
+uint64_t hal_now_ns(hal_dev_t *dev){
+	struct timespec ts;
+	if(dev != NULL)
+		return dev->t_ns;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec*1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/** ****************************************************************
+ * Sleep until absolute time
+ *
+ * @param dev robot device, NULL for host monotonic clock
+ * @param t_ns absolute wakeup time in ns
+ * @brief function that run simulation until t_ns, without waiting
+ * @return 0 when ok
+***************************************************************** */
+int hal_sleep_until(hal_dev_t *dev, uint64_t t_ns){
+	struct timespec ts;
+	uint64_t dt;
+	if(dev == NULL){
+		ts.tv_sec = t_ns / 1000000000ULL;
+		ts.tv_nsec = t_ns % 1000000000ULL;
+		while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR);
+		return 0;
+	}
+	while(dev->t_ns < t_ns){
+		dt = t_ns - dev->t_ns;
+		if(dt > SIM_STEP_NS)
+			dt = SIM_STEP_NS;
+		sim_step(dev, dt);
+		dev->t_ns += dt;
+	}
+	return 0;
+}
@@ -0,0 +1,20 @@
+/** ****************************************************************
+ * @file hal_sim.h
+ * @brief Hardware abstraction layer, simulated backend extensions.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * Entry points of the simulated robot that are not part of hal.h,
+ * used by the batch runner to create one robot per episode.
+***************************************************************** */
+#ifndef HAL_SIM_H
+#define HAL_SIM_H
+
+#include "hal.h"
+
+hal_dev_t *hal_sim_open(unsigned int seed);
+unsigned long hal_sim_collisions(const hal_dev_t *dev);
+int hal_sim_destroy(hal_dev_t *dev);
+
+#endif
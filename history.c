@@ -0,0 +1,70 @@
+/** ****************************************************************
+ * @file history.c
+ * @brief Ring of the last timestamped IR frames.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * One slot of the ring is always the frame of the actual tick, so a
+ * ring of HISTORY_DEPTH keeps HISTORY_DEPTH-1 committed frames.
+***************************************************************** */
+#include "history.h"
+#include <string.h>
+
+const history_frame_t history_zero; ///< frame of zeros, used as history before first frame
+
+/** ****************************************************************
+ * Init history
+ *
+ * @param h history
+ * @brief function that empty history
+ * @return 0 when ok
+***************************************************************** */
+int history_init(history_t *h){
+	memset(h, 0, sizeof(*h));
+	return 0;
+}
+
+/** ****************************************************************
+ * Next frame
+ *
+ * @param h history
+ * @brief function that give the frame of actual tick, written in place
+ * @return frame to write, it is overwritten until history_commit()
+***************************************************************** */
+history_frame_t *history_next(history_t *h){
+	return &h->frames[h->head % HISTORY_DEPTH];
+}
+
+/** ****************************************************************
+ * Commit frame
+ *
+ * @param h history
+ * @brief function that make frame of actual tick the newest frame of history
+ * @return 0 when ok
+***************************************************************** */
+int history_commit(history_t *h){
+	h->head++;
+	return 0;
+}
+
+/** ****************************************************************
+ * Velocity over several frames
+ *
+ * @param h history
+ * @param ch channel
+ * @param age committed frame compared with the frame of actual tick, 0 for previous tick
+ * @brief function that give mean velocity of a channel between the frame of actual tick and a committed one
+ * @return velocity (in value units per us), 0 if history is not that deep
+ * @note the frame of actual tick must be written, velocity is over age+1 frame periods
+***************************************************************** */
+float history_velocity(const history_t *h, int ch, int age){
+	const history_frame_t *a, *b;
+	if(age < 0 || age >= history_count(h))
+		return 0.0f;
+	a = &h->frames[h->head % HISTORY_DEPTH];
+	b = history_get(h, age);
+	if(a->t_ns <= b->t_ns)
+		return 0.0f;
+	return (a->v[ch] - b->v[ch]) / ((a->t_ns - b->t_ns) / 1000.0f);
+}
@@ -0,0 +1,79 @@
+/** ****************************************************************
+ * @file history.h
+ * @brief Ring of the last timestamped IR frames.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * Frames are written in place by the preprocessing kernel and never
+ * copied, a tick only moves the ring head. A frame is one cache line,
+ * channels are contiguous so kernels can stream over frames.
+***************************************************************** */
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdint.h>
+
+#define HISTORY_CHANNELS 8 ///< number of channels of a frame (IR sensors)
+#ifndef HISTORY_DEPTH
+#define HISTORY_DEPTH 16 ///< number of frames kept (power of 2), build with -DHISTORY_DEPTH=n to change it
+#endif
+#define HISTORY_ALIGN 64 ///< cache line size of Cortex-A8 (in bytes)
+
+#if HISTORY_DEPTH < 2 || (HISTORY_DEPTH & (HISTORY_DEPTH-1))
+#error "HISTORY_DEPTH must be a power of 2, at least 2"
+#endif
+
+/** ****************************************************************
+ * History frame
+ *
+ * @brief clamped IR values of one tick and acquisition time
+***************************************************************** */
+typedef struct {
+	int v[HISTORY_CHANNELS]; ///< clamped IR values
+	uint64_t t_ns; ///< acquisition time (in ns)
+} __attribute__((aligned(HISTORY_ALIGN))) history_frame_t;
+
+/** ****************************************************************
+ * History ring
+ *
+ * @brief last HISTORY_DEPTH frames, the one at head is being written
+***************************************************************** */
+typedef struct {
+	history_frame_t frames[HISTORY_DEPTH]; ///< frames
+	uint32_t head; ///< number of committed frames, frames[head % HISTORY_DEPTH] is the next one
+} history_t;
+
+extern const history_frame_t history_zero; ///< frame of zeros, used as history before first frame
+
+int history_init(history_t *h);
+history_frame_t *history_next(history_t *h);
+int history_commit(history_t *h);
+float history_velocity(const history_t *h, int ch, int age);
+
+/** ****************************************************************
+ * Frames in history
+ *
+ * @param h history
+ * @brief function that give the number of committed frames kept
+ * @return number of frames, at most HISTORY_DEPTH-1
+***************************************************************** */
+static inline int history_count(const history_t *h){
+	return h->head < HISTORY_DEPTH-1 ? (int)h->head : HISTORY_DEPTH-1;
+}
+
+/** ****************************************************************
+ * Get a committed frame
+ *
+ * @param h history
+ * @param age 0 for newest committed frame, 1 for the one before...
+ * @brief function that give a frame of history without copy
+ * @return frame, history_zero if history is not that deep
+***************************************************************** */
+static inline const history_frame_t *history_get(const history_t *h, int age){
+	if(age < 0 || age >= history_count(h))
+		return &history_zero;
+	return &h->frames[(h->head - 1 - age) % HISTORY_DEPTH];
+}
+
+#endif
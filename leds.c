@@ -0,0 +1,326 @@
+/** ****************************************************************
+ * @file leds.c
+ * @brief Persistent LED animation worker for Khepera IV.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * A single long-lived thread owns the robot leds. Colors and animations
+ * are non-blocking requests, and redundant requests are coalesced.
+***************************************************************** */
+#include "leds.h"
+#include "scheduler.h"
+#include "probe.h"
+#include "rt.h"
+#include "bus.h"
+#include <pthread.h>
+#include <stdio.h>
+
+/** ****************************************************************
+ * LED animation identifiers
+ *
+ * @brief animations, sorted by priority
+***************************************************************** */
+enum {
+	LED_ANIM_NONE = 0, ///< no animation
+	LED_ANIM_DAMAGE, ///< damage animation
+	LED_ANIM_DEATH ///< death animation, preempts damage animation
+};
+
+/** ****************************************************************
+ * LED animation step
+ *
+ * @brief colors of the 3 leds during one LED_STEP
+***************************************************************** */
+typedef struct {
+	char left; ///< color for left led
+	char right; ///< color for right led
+	char back; ///< color for back led
+} led_step_t;
+
+static const led_step_t damage_steps[] = {
+	{0,0,0},
+	{4,0,0}, {0,4,0}, {0,0,4},
+	{4,0,0}, {0,4,0}, {0,0,4},
+	{4,0,0}, {0,4,0}, {0,0,4},
+	{4,0,0}, {0,4,0}, {0,0,4},
+	{4,0,0}, {0,4,0}, {0,0,4}
+}; ///< damage animation, red leds turning around robot
+
+static const led_step_t death_steps[] = {
+	{0,0,0},
+	{2,0,0}, {0,2,0}, {0,0,2},
+	{2,0,0}, {0,2,0}, {0,0,2},
+	{2,0,0}, {0,2,0}, {0,0,2},
+	{2,0,0}, {0,2,0}, {0,0,2},
+	{4,0,0}, {0,4,0}, {0,0,4},
+	{4,0,0}, {0,4,0}, {0,0,4},
+	{4,0,0}, {0,4,0}, {0,0,4},
+	{4,0,0}, {0,4,0}, {0,0,4},
+	{4,4,4}, {0,0,0},
+	{4,4,4}, {0,0,0},
+	{4,4,4}, {0,0,0},
+	{4,4,4}, {0,0,0},
+	{4,4,4}, {0,0,0},
+	{4,4,4}, {0,0,0}
+}; ///< death animation, green then red leds turning around robot then blinking
+
+/** ****************************************************************
+ * LED worker state
+ *
+ * @brief requests waiting for the LED worker
+ * @note all fields are protected by lock
+***************************************************************** */
+static struct {
+	hal_dev_t *dev; ///< robot device
+	pthread_t thread; ///< LED worker thread
+	pthread_mutex_t lock; ///< protect requests
+	pthread_cond_t cond; ///< signal new requests
+	int running; ///< 1 when worker is started
+	int quit; ///< 1 when worker must exit once requests are done
+	int color_pending; ///< 1 when a color is waiting
+	int color[3]; ///< last requested color for left, right and back leds
+	int anim_pending; ///< highest priority animation waiting
+	int anim_active; ///< animation being played
+} leds = {
+	.lock = PTHREAD_MUTEX_INITIALIZER
+};
+
+/** ****************************************************************
+ * Get rgb components of a color
+ *
+ * @param color, color index (0 off, 1 white, 2 green, 3 blue, 4 red)
+ * @param r, red component
+ * @param g, green component
+ * @param b, blue component
+ * @brief function that convert color index to rgb
+ * @return : 0 when ok
+***************************************************************** */
+static int led_rgb(int color, int32_t *r, int32_t *g, int32_t *b){
+	switch(color){
+		case 1: //white
+			*r=255; *g=255; *b=255;
+			break;
+		case 2: //green
+			*r=0; *g=255; *b=0;
+			break;
+		case 3: //blue
+			*r=0; *g=0; *b=255;
+			break;
+		case 4: //red
+			*r=255; *g=0; *b=0;
+			break;
+		case 0: // off
+		default:
+			*r=0; *g=0; *b=0;
+			break;
+	}
+	return 0;
+}
+
+/** ****************************************************************
+ * Write robot leds
+ *
+ * @param left, color for left led
+ * @param right, color for right led
+ * @param back, color for back led
+ * @brief function that write color of the 3 leds on dsPic, through the bus owner
+ * @note only called by LED worker
+ * @return : 0 when ok
+***************************************************************** */
+static int led_write(int left, int right, int back){
+	int32_t lr, lg, lb, rr, rg, rb, br, bg, bb;
+	led_rgb(left, &lr, &lg, &lb);
+	led_rgb(right, &rr, &rg, &rb);
+	led_rgb(back, &br, &bg, &bb);
+	bus_set_leds(leds.dev, lr, lg, lb, rr, rg, rb, br, bg, bb); // latest color replaces a pending one
+	return 0;
+}
+
+/** ****************************************************************
+ * Play an animation
+ *
+ * @param anim, animation identifier
+ * @brief function that play animation steps, called with lock held
+ * @note lock is released while writing, animation stops if a higher
+ * priority animation is requested
+ * @note steps are not paced in simulation, virtual time does not follow host clock
+ * @return : 0 when ok
+***************************************************************** */
+static int led_play(int anim){
+	const led_step_t *steps = (anim == LED_ANIM_DEATH) ? death_steps : damage_steps;
+	int n = (anim == LED_ANIM_DEATH) ? sizeof(death_steps)/sizeof(death_steps[0]) : sizeof(damage_steps)/sizeof(damage_steps[0]);
+	uint64_t deadline = monotonic_ns();
+	struct timespec ts;
+	int i;
+	leds.anim_active = anim;
+	for(i=0; i<n; i++){
+		pthread_mutex_unlock(&leds.lock);
+		led_write(steps[i].left, steps[i].right, steps[i].back);
+		pthread_mutex_lock(&leds.lock);
+		if(hal_is_simulated())
+			continue;
+		deadline += LED_STEP*1000ULL;
+		ts.tv_sec = deadline / 1000000000ULL;
+		ts.tv_nsec = deadline % 1000000000ULL;
+		while(leds.anim_pending <= anim && monotonic_ns() < deadline)
+			pthread_cond_timedwait(&leds.cond, &leds.lock, &ts);
+		if(leds.anim_pending > anim)
+			break;
+	}
+	leds.anim_active = LED_ANIM_NONE;
+	return 0;
+}
+
+/** ****************************************************************
+ * LED worker
+ *
+ * @param args unused
+ * @brief thread that serve LED requests, animations first
+***************************************************************** */
+static void* led_worker(void *args){
+	int anim, left, right, back;
+	rt_thread(RT_BACKGROUND);
+	pthread_mutex_lock(&leds.lock);
+	while(1){
+		while(!leds.quit && !leds.color_pending && !leds.anim_pending)
+			pthread_cond_wait(&leds.cond, &leds.lock);
+		if(leds.anim_pending){
+			anim = leds.anim_pending;
+			leds.anim_pending = LED_ANIM_NONE;
+			led_play(anim);
+		}
+		else if(leds.color_pending){
+			left = leds.color[0];
+			right = leds.color[1];
+			back = leds.color[2];
+			leds.color_pending = 0;
+			pthread_mutex_unlock(&leds.lock);
+			led_write(left, right, back);
+			pthread_mutex_lock(&leds.lock);
+		}
+		else if(leds.quit)
+			break;
+	}
+	pthread_mutex_unlock(&leds.lock);
+	return NULL;
+}
+
+/** ****************************************************************
+ * Start LED worker
+ *
+ * @param dev robot device
+ * @brief function that start the LED worker thread
+ * @return : 0 when ok, -1 if error
+***************************************************************** */
+int leds_start(hal_dev_t *dev){
+	pthread_condattr_t attr;
+	leds.dev = dev;
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&leds.cond, &attr);
+	pthread_condattr_destroy(&attr);
+	leds.quit = 0;
+	if(pthread_create(&leds.thread, NULL, &led_worker, NULL) != 0){
+		printf("ERROR: could not create LED worker\n");
+		return -1;
+	}
+	leds.running = 1;
+	return 0;
+}
+
+/** ****************************************************************
+ * Set LED worker class
+ *
+ * @param cls thread class (see rt.h)
+ * @brief function that set scheduling class of the LED worker, started before real-time mode
+ * @return 0 when ok, -1 if error
+***************************************************************** */
+int leds_thread_class(int cls){
+	if(!leds.running)
+		return 0;
+	return rt_set(leds.thread, cls);
+}
+
+/** ****************************************************************
+ * Stop LED worker
+ *
+ * @brief function that wait for pending requests and stop LED worker
+ * @return : 0 when ok
+***************************************************************** */
+int leds_stop(void){
+	if(!leds.running)
+		return 0;
+	pthread_mutex_lock(&leds.lock);
+	leds.quit = 1;
+	pthread_cond_signal(&leds.cond);
+	pthread_mutex_unlock(&leds.lock);
+	pthread_join(leds.thread, NULL);
+	leds.running = 0;
+	return 0;
+}
+
+/** ****************************************************************
+ * Set robot leds
+ * 
+ * @param left, color for left led
+ * @param right, color for right led 
+ * @param back, color for back led 
+ * @note For color selection : (0 off, 1 white, 2 green, 3 blue, 4 red)
+ * @brief function that request color for robot leds, never block on the bus
+ * @note a color waiting for the worker is replaced by the newest one
+ * @return : 0 when ok
+***************************************************************** */
+int set_leds(int left, int right, int back){
+	pthread_mutex_lock(&leds.lock);
+	leds.color[0] = left;
+	leds.color[1] = right;
+	leds.color[2] = back;
+	leds.color_pending = 1;
+	pthread_cond_signal(&leds.cond);
+	pthread_mutex_unlock(&leds.lock);
+	return 0;
+}
+
+/** ****************************************************************
+ * Turn off leds 
+ * 
+ * @brief function that turn of all leds
+ * @return : 0 when ok
+***************************************************************** */
+int turn_off_leds(void){
+	set_leds(0,0,0);
+	return 0;
+}
+
+/** ****************************************************************
+ * Robot damage animation 
+ * 
+ * @brief function that request animation when robot has damage
+ * @note request is merged if a damage animation is already playing or waiting
+ * @return : 0 when ok
+***************************************************************** */
+int damage_animation(void){
+	pthread_mutex_lock(&leds.lock);
+	if(leds.anim_active < LED_ANIM_DAMAGE && leds.anim_pending < LED_ANIM_DAMAGE){
+		leds.anim_pending = LED_ANIM_DAMAGE;
+		pthread_cond_signal(&leds.cond);
+	}
+	pthread_mutex_unlock(&leds.lock);
+	return 0;
+}
+
+/** ****************************************************************
+ * Robot death animation 
+ * 
+ * @brief function that request animation for death
+ * @note death animation interrupts a playing damage animation
+ * @return : 0 when ok
+***************************************************************** */
+int death_animation(void){
+	pthread_mutex_lock(&leds.lock);
+	leds.anim_pending = LED_ANIM_DEATH;
+	pthread_cond_signal(&leds.cond);
+	pthread_mutex_unlock(&leds.lock);
+	return 0;
+}
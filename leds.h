@@ -0,0 +1,26 @@
+/** ****************************************************************
+ * @file leds.h
+ * @brief Persistent LED animation worker for Khepera IV.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * A single long-lived thread owns the robot leds. Colors and animations
+ * are non-blocking requests, and redundant requests are coalesced.
+***************************************************************** */
+#ifndef LEDS_H
+#define LEDS_H
+
+#include "hal.h"
+
+#define LED_STEP 50000 ///< duration of an animation step (in us)
+
+int leds_start(hal_dev_t *dev);
+int leds_stop(void);
+int leds_thread_class(int cls);
+int set_leds(int left, int right, int back);
+int turn_off_leds(void);
+int damage_animation(void);
+int death_animation(void);
+
+#endif
@@ -7,333 +7,155 @@
  *
  * Decision making model based on a TRP homeostatis model with a Khepera IV robot.
 ***************************************************************** */
-#include <khepera/khepera.h>
-#include <pthread.h>
+#include "model.h"
 #include <stdio.h> 
 #include <stdlib.h>
 #include <math.h>
+#include <string.h>
+#include "leds.h"
+#include "telemetry.h"
+#include "probe.h"
+#include "agent.h"
+#include "replay.h"
+#include "rt.h"
+#include "bench.h"
+#include "bus.h"
+#include "teleop.h"
+#ifdef MODEL_SIM
+#include "runner.h"
+#endif
 
 #define _USE_MATH_DEFINES ///< for using math constants
-#define SPEED 200  ///< speed basic input
-#define TIME 100000///< time for model update (in ms)
-#define MAXBUFFERSIZE 128 ///< Buffer size for robot communication
-#define MAX_DIST 500 ///< Maximum distance for ir sensor
-#define MIN_DIST 80 ///< or 70 | minimum distance for ir sensor
 
-knet_dev_t * dsPic; ///< robot pic microcontroller access
-
-float left_speed; ///< speed of left motor
-float right_speed; ///< speed of right motor
-
-float var_energy  = 1.0; ///< physological variable for ernergy
-float var_tegument = 1.0; ///< physological variable for tegument
-float var_integrity = 1.0; ///< physological variable for integrity
-
-float def_energy  = 1.0; ///< deficit for ernergy
-float def_tegument = 1.0; ///< deficit for tegument
-float def_integrity = 1.0; ///< deficit for integrity
-
-float cue_energy  = 1.0; ///< cue for ernergy
-float cue_tegument = 1.0; ///< cue for tegument
-float cue_integrity = 1.0; ///< cue for integrity
-
-float mot_energy  = 1.0; ///< motivation for ernergy
-float mot_tegument = 1.0; ///< motivation for tegument
-float mot_integrity = 1.0; ///< motivation for integrity
-
-int _secure_led_animation = 0; ///< to secure threading led animation
-
-int prev_sensors[8]; ///< to store previous sensors values for
-int sensors[8]; ///< actual sensors values
-
-float speed[8]; ///< table for speeed based on IR sensor values
-float circ_speed[7]; ///< table for circular speeed based on IR sensor values (size is n-1 because of circular speeed)
+const char *telemetry_path = TELEMETRY_FILE; ///< binary telemetry file
+long telemetry_view = 0; ///< console view period (in ms), 0 if disabled
+const char *telemetry_udp = NULL; ///< monitoring host as host:port, NULL if not streamed
 
 /** ****************************************************************
  * Display robot battery informations
  * 
+ * @param m model context
  * @brief display battery info
  * @return : 0
 ***************************************************************** */
-int display_battery(){
+int display_battery(model_t *m){
 	char buf[32]; // Uses 12 bytes, extra space for future compat
-	kh4_battery_status(buf, dsPic);
+	int charge;
+	bus_battery_status(m->robot, buf);
+	charge = bus_battery_charge(m->robot);
 	printf("Battery charge: %d%%\n", buf[3]);
 	printf("Current: %4.0f mA\n",*(short*)(buf+4)*0.07813);
 	printf("Temperature: %3.1f C\n",*(short*)(buf+8)*0.003906);
 	printf("Voltage: %4.0f mV\n",*(short*)(buf+10)*9.76);
-	printf("Charger: %s\n",kh4_battery_charge(dsPic)?"plugged":"unplugged");
-	return 0;
-}
-
-/** ****************************************************************
- * Set robot leds
- * 
- * @param left, color for left led
- * @param right, color for right led 
- * @param back, color for back led 
- * @note For color selection : (0 off, 1 white, 2 green, 3 blue, 4 red)
- * @brief function that set color for 4 robot leds
- * @return : 0 when ok
-***************************************************************** */
-int set_leds(int left, int right, int back){
-	int32_t lr, lg, lb, rr, rg, rb, br, bg, bb;
-	switch(left){
-		case 0: // off
-			lr=0; lg=0; lb=0;
-			break;
-		case 1: //white
-			lr=255; lg=255; lb=255;
-			break;
-		case 2: //green
-			lr=0; lg=255; lb=0;
-			break;
-		case 3: //blue
-			lr=0; lg=0; lb=255;
-			break;
-		case 4: //red
-			lr=255; lg=0; lb=0;
-			break;
-	}
-	switch(right){
-		case 0: // off
-			rr=0; rg=0; rb=0;
-			break;
-		case 1: //white
-			rr=255; rg=255; rb=255;
-			break;
-		case 2: //green
-			rr=0; rg=255; rb=0;
-			break;
-		case 3: //blue
-			rr=0; rg=0; rb=255;
-			break;
-		case 4: //red
-			rr=255; rg=0; rb=0;
-			break;
-	}
-	switch(back){
-		case 0: // off
-			br=0; bg=0; bb=0;
-			break;
-		case 1: //white
-			br=255; bg=255; bb=255;
-			break;
-		case 2: //green
-			br=0; bg=255; bb=0;
-			break;
-		case 3: //blue
-			br=0; bg=0; bb=255;
-			break;
-		case 4: //red
-			br=255; bg=0; bb=0;
-			break;
-	}
-
-	kh4_SetRGBLeds(lr, lg, lb, rr, rg, rb, br, bg, bb, dsPic);
-	return 0;
-}
-
-/** ****************************************************************
- * Turn off leds 
- * 
- * @brief function that turn of all leds
- * @return : 0 when ok
-***************************************************************** */
-int turn_off_leds(){
-	set_leds(0,0,0);
-	return 0;
-}
-
-/** ****************************************************************
- * Robot death animation 
- * 
- * @brief function that make animation for death
- * @return : 0 when ok
-***************************************************************** */
-int death_animation(){
-	int animation_time = 50000;
-	int i;
-	set_leds(0,0,0);
-	usleep(animation_time);	
-	for(i=0; i<4; i++){
-		set_leds(2,0,0);
-		usleep(animation_time);
-		set_leds(0,2,0);
-		usleep(animation_time);
-		set_leds(0,0,2);
-		usleep(animation_time);
-	}	
-	for(i=0; i<4; i++){
-		set_leds(4,0,0);
-		usleep(animation_time);
-		set_leds(0,4,0);
-		usleep(animation_time);
-		set_leds(0,0,4);
-		usleep(animation_time);
-	}	
-	for(i=0; i<6; i++){
-		set_leds(4,4,4);
-		usleep(animation_time);
-		set_leds(0,0,0);
-		usleep(animation_time);
-	}	
-
+	printf("Charger: %s\n",charge?"plugged":"unplugged");
 	return 0;
 }
- 
-/** ****************************************************************
- * Robot damage animation 
- * 
- * @brief function that make animation when robot has damage
- * @note _secure_led_animation is used to secure threading
-***************************************************************** */
-void* damage_animation(void *args){
-	_secure_led_animation = 1;
-	int animation_time = 50000;
-	int i;
-	set_leds(0,0,0);
-	usleep(animation_time);	
-	for(i=0; i<5; i++){
-		set_leds(4,0,0);
-		usleep(animation_time);
-		set_leds(0,4,0);
-		usleep(animation_time);
-		set_leds(0,0,4);
-		usleep(animation_time);
-	}	
-	_secure_led_animation = 0;
-}
 
 /** ****************************************************************
  * Function that takes motivations as input and return behaviral group
  * 
  * @brief Winner take all for decision making
- * @param m1 motivation for ernergy
- * @param m2 motivation for tegument
- * @param m3 motivation for integrity 
- * @return 1 if energy, 2 if tegument, 3 if integrity, -1 if error
- * @note WTA is used for selection
-***************************************************************** */
-int winner_takes_all(float m1, float m2, float m3){
-	if((m1 > m2) && (m1 > m3))
-		return 1;
-	else if((m2 > m1) && (m2 > m3))
-		return 2;
-	else if((m3 > m1) && (m3 > m2))
-		return 3;
-	else
-		return -1;
+ * @param mot motivations, indexed by need
+ * @param n number of motivations
+ * @return index of the need with highest motivation
+ * @note WTA is used for selection, on a tie the need listed first in NEED_LIST wins
+ * @note selects are done without branches, cost is one compare per need
+***************************************************************** */
+int winner_takes_all(const homeo_t mot[], int n){
+	int i, gt, best = 0;
+	homeo_t best_mot = mot[0];
+	for(i=1; i<n; i++){
+		gt = mot[i] > best_mot;
+		best = gt ? i : best;
+		best_mot = gt ? mot[i] : best_mot;
+	}
+	return best;
 }
 
 /** ****************************************************************
  * Make robot stop
  * 
+ * @param m model context
  * @brief stop robot's motor
  * @return : none
  * @note Robot's wheels are stopeed and robot is set in stop mode.
 ***************************************************************** */
-int stop_moving(){
+int stop_moving(model_t *m){
 	// Stop wheel motors
 	printf("Stopping motors\n");
-	kh4_SetMode(kh4RegSpeed, dsPic);
-	kh4_set_speed(0, 0, dsPic);
+	motors_stop(&m->motors);
 	// LEDs off
-	kh4_SetRGBLeds(0, 0, 0, 0, 0, 0, 0, 0, 0, dsPic);
-	kh4_SetMode(kh4RegIdle, dsPic);
+	if(m->leds)
+		turn_off_leds();
 	return 0;
 }
 
 /** ****************************************************************
  * Make robot move
+ * @param m model context
  * @brief function to make robot move
  * @param motor_left speed of robot left wheel in [-1.0,1.0] range
  * @param motor_right speed of robot right wheel in [-1.0,1.0] range 
- * @return : none
- * @note speed is computed with SPEED int, value is set to 200
+ * @return : 0 when ok
+ * @note speed is computed with speed parameter, 200 by default
+ * @note command is written by motors_commit(), only the last move of a tick is sent
 ***************************************************************** */
-int move(float motor_left, float motor_right){
-	kh4_SetMode(kh4RegSpeed, dsPic);
-	if (kh4_set_speed(motor_left*SPEED, motor_right*SPEED, dsPic) < 0){
-		printf("ERROR: Fail on set_speed\n");
-		return -1;
-	}
-}
-
-/** ****************************************************************
- * Control robot with keyboard
- * 
- * @return : none
- * @brief Robot is controlled with zqsd input, a for quit, e for stop
-***************************************************************** */
-int run(void){
-	char ctrl;  // char used for keyboard input
-	ctrl = 'r';
-	while(ctrl!='a'){
-		printf("z,q,s,d for robot control, e for stop, a for exit\n");
-		scanf("%c", &ctrl);
-		printf("%c \n", ctrl);
-		switch(ctrl){
-			case 'z':
-				printf("Move forward\n");
-				move(1.0,1.0);
-			break;
-			case 'q':
-				printf("Move left\n");
-				move(-1.0,1.0);
-			break;
-			case 's':
-				printf("Move backwardt\n");
-				move(-1.0,-1.0);
-			break;
-			case 'd':
-				printf("Move right\n");
-				move(1.0,-1.0);
-			break;
-			case 'e':
-				stop_moving();
-			break;
-			case 'a':
-				printf("Exit program\n");
-				stop_moving();
-			break;
-			default:
-				printf("Error : Unknown command\n");
-		}
-	}
-	
+int move(model_t *m, float motor_left, float motor_right){
+	m->left_speed = motor_left;
+	m->right_speed = motor_right;
+	return motors_request(&m->motors, motor_left, motor_right);
 }
 
 /** ****************************************************************
  * Induce damage
  * 
+ * @param m model context
  * @return 0 when ok
  * @param level, the level of damage from 0 to 1
- * @brief function that decrease physiological variable for integrity 
-***************************************************************** */
-int induce_damage(float level){
-	var_integrity -= (level*0.01);
-	update_vars(0);
-	if(_secure_led_animation == 0){
-		// Thread id
-		pthread_t threadId;
-		// Create a thread that will function damage_animation()
-		int err = pthread_create(&threadId, NULL, &damage_animation, NULL);
-		// Check if thread is created sucessfuly
-	}
+ * @brief function that add a damage contribution to the tick accumulator
+ * @note integrity is only decreased by apply_damage(), once per tick
+***************************************************************** */
+int induce_damage(model_t *m, float level){
+	if(level == 0.0)
+		return 0;
+	m->damage_acc.level += (level*m->params->damage_scale);
+	m->damage_acc.hits++;
 	return 0;
 }
 
+/** ****************************************************************
+ * Apply damage
+ * 
+ * @param m model context
+ * @return 0 when no damage, 1 when damage was applied
+ * @brief function that decrease physiological variable for integrity with accumulated damage
+***************************************************************** */
+int apply_damage(model_t *m){
+	if(m->damage_acc.hits == 0)
+		return 0;
+	m->var[NEED_INTEGRITY] -= homeo_from_float(m->damage_acc.level);
+	m->var_dirty |= 1u << NEED_INTEGRITY;
+	if(m->fleet)
+		agent_event(m, FLEET_DAMAGE, (int)(m->damage_acc.level*1000000.0), 0);
+	if(m->leds)
+		damage_animation(); // non blocking, merged if already playing
+	m->damage_acc.level = 0.0;
+	m->damage_acc.hits = 0;
+	return 1;
+}
+
 /** ****************************************************************
  * Read and print our sensors
  * 
+ * @param m model context
  * @return 0 if ok, -2 if error
  * @brief function to read and print robot's ir and us sensors
 ***************************************************************** */
-int read_and_print_sensors(void){
+int read_and_print_sensors(model_t *m){
 	char Buffer[MAXBUFFERSIZE], buf[MAXBUFFERSIZE];
 	int i, sensor, ret;
-	if(kh4_proximity_ir((char *)Buffer, dsPic)>=0){	
+	ret = bus_proximity_ir(m->robot, (char *)Buffer);
+	if(ret>=0){	
 		printf("Reading sensor proximity \n");
 		for (i=0;i<12;i++){
 			sensor=(Buffer[i*2] | Buffer[i*2+1]<<8);
@@ -345,7 +167,8 @@ int read_and_print_sensors(void){
 	else
 		ret = -2;
 
-	if(kh4_measure_us((char *)Buffer, dsPic)>=0)
+	ret = bus_measure_us(m->robot, (char *)Buffer);
+	if(ret>=0)
 	{
 		sprintf(buf,"g");
 		printf("Reading sensor us \n");
@@ -363,156 +186,222 @@ int read_and_print_sensors(void){
 /** ****************************************************************
  * Store previous sensors values
  * 
+ * @param m model context
  * @return 0 if ok
  * @brief function that store actual for sensor values for later use
+ * @note nothing is copied, frame of actual tick is committed in history ring
 ***************************************************************** */
-int get_sensors_history(void){
-	int i;
-	for(i=0; i<8;i++){ 
-		prev_sensors[i] = sensors[i];
-	}
-	return 0;
+int get_sensors_history(model_t *m){
+	return history_commit(&m->history);
 }
 
 /** ****************************************************************
  * Read and store  sensor values
  * 
+ * @param m model context
  * @return 0 if ok
  * @brief function to read and store sensors values
+ * @note newest frame of acquisition thread is used, this function never wait for the bus
+ * @note speeds of speed_damage() and circular masks of circ_damage() are updated here
 ***************************************************************** */
-int get_sensors(void){
-		char Buffer[256];
-		int sensval, i;
+int get_sensors(model_t *m){
+		int i;
+		ir_frame_t *frame = &m->frame;
+		history_frame_t *h = history_next(&m->history);
 		// get ir sensor
-		kh4_proximity_ir(Buffer, dsPic);				 
-		//limit the sensor values, don't use ground sensors
-		for (i = 0; i < 8; i++)	
-		{
-			sensval = (Buffer[i*2] | Buffer[i*2+1]<<8);
-			if(sensval > MAX_DIST)
-				sensors[i] = MAX_DIST;
-			else if (sensval < MIN_DIST)
-				sensors[i] = 0;
-			else
-				sensors[i] = (sensval-MIN_DIST)>>1;
-		}
+		acquisition_latest(&m->acquisition, frame);
+		m->sensors_t_ns = frame->t_ns;
+		h->t_ns = frame->t_ns;
+		m->sensors = h->v; // kernel writes in history ring
+		m->prev_sensors = history_get(&m->history, 0)->v;
+		//limit the sensor values, don't use ground sensors, sensor speeds and means are computed in the same pass
+		preprocess_frame(frame->ir, m->sensors, m->prev_sensors, m->speed, m->tick_dt, m->params, &m->pre);
+		stats_push(&m->ir_stats, m->sensors); // window statistics are updated once per frame
+		m->ir_moving = 0;
+		for(i=0; i<STATS_CHANNELS; i++)
+			m->ir_moving |= (stats_max(&m->ir_stats, i) - stats_min(&m->ir_stats, i) > PRE_SPEED_DIFF(m->params)) << i;
+		if(m->fusion)
+			fusion_update(&m->perception, frame); // ground and ultrasounds of the same frame
+		for(i=0; i<NEED_COUNT; i++)
+			if(behaviours[i].cue_fn)
+				m->cue_dirty |= 1u << i; // cues computed from perception follow the frame
 	return 0;
 }
 
 /** ****************************************************************
  * Compute internal deficits
  * 
+ * @param m model context
  * @return 0 when ok
  * @brief function that compute deficits for physiological internal values 
+ * @note only deficits of changed variables are computed, their motivations are marked
 ***************************************************************** */
-int compute_deficit(void){
-	// def_energy = (0.85 - var_energy)>0 ?(0.85 - var_energy) : 0.0 ;
-	// def_tegument = (0.85 - var_tegument)>0 ?(0.85 - var_tegument) : 0.0 ;
-	// def_integrity = (0.85 - var_integrity)>0 ?(0.85 - var_integrity) : 0.0 ;
-	def_energy = 1.0 - var_energy;
-	def_tegument = 1.0 - var_tegument;
-	def_integrity = 1.0 - var_integrity;
+int compute_deficit(model_t *m){
+	int i;
+	for(i=0; i<NEED_COUNT; i++){
+		if(!(m->var_dirty & (1u << i)))
+			continue;
+		// def[i] = (0.85 - var[i])>0 ?(0.85 - var[i]) : 0.0 ;
+		m->def[i] = HOMEO_ONE - m->var[i];
+	}
+	m->mot_dirty |= m->var_dirty;
+	m->var_dirty = 0;
 	return 0;
 }
 
 /** ****************************************************************
  * Compute motivations
  * 
+ * @param m model context
  * @return 0 when ok
  * @brief function that compute motivations for physiological internal values 
+ * @note only motivations whose deficit or cue changed are computed
 ***************************************************************** */
-int compute_motivations(void){
-	mot_energy = def_energy + (def_energy * cue_energy);
-	mot_tegument = def_tegument + (def_tegument * cue_tegument);
-	mot_integrity = def_integrity + (def_integrity * cue_integrity);
+int compute_motivations(model_t *m){
+	int i;
+	for(i=0; i<NEED_COUNT; i++)
+		if(m->mot_dirty & (1u << i))
+			m->mot[i] = m->def[i] + homeo_mul(m->def[i], m->cue[i]);
+	m->mot_dirty = 0;
 	return 0;
 }
 
 /** ****************************************************************
- * Get mean and normalize a table
+ * Compute cues
  * 
- * @return mean noramlized between 0 and 1
- * @brief function that get mean of table and normalize it
+ * @param m model context
+ * @return 0 when ok
+ * @brief function that compute cues
+ * @note only cues whose source changed are computed, motivations are marked when a cue value changes
 ***************************************************************** */
-float get_mean_normalized(int table[], int size, int min, int max){
-	float mean;
+int compute_cues(model_t *m){
+	homeo_t cue;
 	int i;
-	for(i=0; i<size; i++){
-		mean += table[i];
+	for(i=0; i<NEED_COUNT; i++){
+		if(!(m->cue_dirty & (1u << i)))
+			continue;
+		cue = behaviours[i].cue_fn ? behaviours[i].cue_fn(m) : m->params->cue[i];
+		if(cue != m->cue[i])
+			m->mot_dirty |= 1u << i;
+		m->cue[i] = cue;
 	}
-	mean /= size;
-	return ((mean-min)/(max-min));
+	m->cue_dirty = 0;
+	return 0;
 }
 
 /** ****************************************************************
- * Get mean and normalize a  float table
+ * Get motivations
  * 
- * @return mean noramlized between 0 and 1
- * @brief function that get mean of table and normalize it but for a float table
+ * @param m model context
+ * @return motivations, indexed by need
+ * @brief function that bring deficits, cues and motivations up to date and give motivations
+ * @note nothing is computed when no variable, frame or parameter changed since the last call
 ***************************************************************** */
-float get_mean_normalized_f(float table[], int size, float min, float max){
-	float mean;
-	int i;
-	for(i=0; i<size; i++){
-		mean += table[i];
-	}
-	mean /= size;
-	return ((mean-min)/(max-min));
+const homeo_t *motivations(model_t *m){
+	if(m->var_dirty)
+		compute_deficit(m);
+	if(m->cue_dirty)
+		compute_cues(m);
+	if(m->mot_dirty)
+		compute_motivations(m);
+	return m->mot;
 }
 
 /** ****************************************************************
- * Compute cues
+ * Integrity cue
  * 
- * @return 0 when ok
- * @brief function that compute cues
+ * @param m model context
+ * @return cue for integrity
+ * @brief function that give integrity cue from normalized mean of IR sensors, computed by get_sensors()
+ * @note with cue_alpha below 1, the EWMA of the mean over frames is used instead of the actual frame
 ***************************************************************** */
-int compute_cues(void){
-	cue_energy = 0.06;
-	cue_tegument = 0.055;
-	cue_integrity = get_mean_normalized(sensors,8,MIN_DIST, MAX_DIST);
-	return 0;
+homeo_t integrity_cue(model_t *m){
+	float mean;
+	if(m->cue_alpha < 1.0f){
+		mean = m->ir_stats.ewma_total / STATS_CHANNELS;
+		return homeo_from_float((mean-m->params->min_dist)/(m->params->max_dist-m->params->min_dist));
+	}
+	return homeo_from_float(m->pre.ir_mean);
 }
 
 /** ****************************************************************
  * Decrease physoligical variables
  * 
+ * @param m model context
  * @return 0 when ok
  * @brief function that decrease physiological variables 
 ***************************************************************** */
-int decrease_physoligical_variables(void){
-	var_energy -= 0.004;
-	var_tegument -= 0.0015;
+int decrease_physoligical_variables(model_t *m){
+	int i;
+	for(i=0; i<NEED_COUNT; i++){
+		if(m->decay[i] == 0)
+			continue;
+		m->var[i] -= m->decay[i];
+		m->var_dirty |= 1u << i;
+	}
 	return 0;
 }
 
+/** ****************************************************************
+ * Check if alive
+ * 
+ * @param m model context
+ * @return 1 when all physiological variables are above 0, 0 otherwise
+ * @brief function that check physiological variables
+***************************************************************** */
+int is_alive(model_t *m){
+	int i;
+	for(i=0; i<NEED_COUNT; i++)
+		if(m->var[i] <= 0)
+			return 0;
+	return 1;
+}
+
+/** ****************************************************************
+ * Cause of death
+ * 
+ * @param m model context
+ * @return need whose variable reached 0, -1 if alive
+ * @brief function that give which physiological variable stopped the model
+ * @note first need listed is given if several variables reached 0
+***************************************************************** */
+int model_death_cause(const model_t *m){
+	int i;
+	for(i=0; i<NEED_COUNT; i++)
+		if(m->var[i] <= 0)
+			return i;
+	return -1;
+}
+
 /** ****************************************************************
  * TODO Circular damage function
  * 
+ * @param m model context
  * @return 0 when not, 1 when yes
  * @brief function that compute circulare based damage 
+ * @note speeds are those of actual tick only: a sensor counts when it is near and moved over the stats window,
+ * the circular speed of a sensor resting on an obstacle or out of contact is 0
 ***************************************************************** */
-int circ_damage(void){
+int circ_damage(model_t *m){
 	// TODO debug this function
 	int i;
-	int diff[7]; // generate an array of n-1 value to compute difference between ith sensor and ith-1 history value 
-	float ray = 6; // robot's ray in cm
-	for(i=1; i<7; i++){
-		diff[i] = (sensors[i]-prev_sensors[i-1]); // compute distance between neighboor sensor history and actual value
-		if(abs(diff[i]) < 0.5*sensors[i]){ // if this difference is less than 50% of actual sensor value
-			circ_speed[i] = (M_PI*ray)/TIME;
-		}
-		// printf("s[%d]=%d-ps[%d]=%d => d[%d]=%d ",i, sensors[i], i-1, prev_sensors[i-1], i, diff[i]); 
+	float ray = m->params->circ_ray; // robot's ray in cm
+	for(i=0; i<7; i++){
+		// difference between neighboor sensor history and actual value is less than 50% of actual sensor value
+		m->circ_speed[i] = (m->pre.circ_near & m->ir_moving & (1u<<i)) ? (M_PI*ray)/m->tick_dt : 0.0f;
 		// printf(" s[%d]:%.2f | ",i, circ_speed[i]);
 	}
 	//  Now we're computing if scratching is spreading aroung robot and increasing damage if so
 	for(i=1; i<7; i++){
-		if( abs(circ_speed[i]-circ_speed[i-1]) < 0.5*circ_speed[i]){
-			circ_speed[i-1] *= 2;
-			circ_speed[i] *= 2;
+		if( abs(m->circ_speed[i]-m->circ_speed[i-1]) < m->params->circ_spread*m->circ_speed[i]){
+			m->circ_speed[i-1] *= 2;
+			m->circ_speed[i] *= 2;
 		}
 	}
+	m->circ_active = 0;
 	for(i=0;i<7; i++){
-		induce_damage(circ_speed[i]); // inducing damage based on speed
+		induce_damage(m, m->circ_speed[i]); // inducing damage based on speed
+		m->circ_active |= m->circ_speed[i] != 0.0f;
 	}
 	return 0;
 }
@@ -520,32 +409,24 @@ int circ_damage(void){
 /** ****************************************************************
  * TODO Speed damage function
  * 
+ * @param m model context
  * @return 0 when not, 1 when yes
  * @brief function that compute speed based damage 
+ * @note sensor speeds are velocities over the last SPEED_FRAMES frames of history, a one frame spike does not damage,
+ * they are in fraction of max_dist-min_dist per s so the threshold does not depend on the loop period
 ***************************************************************** */
-int speed_damage(void){
-	int i;
-	int diff[8];
-	for(i=0; i<8; i++){
-		// TODO : FIX ERROR HERE
-		diff[i] = (sensors[i]-prev_sensors[i]); // compute distance between previous and current sensor data
-		if(abs(diff[i]) > 0.05*(MAX_DIST-MIN_DIST)){ // if distance is greater than 5% of the actual MAX_DIST-MIN_DIST
-			speed[i] = (speed[i] + (diff[i]/TIME))/2.0; // speed get mean of it previous value and actual speed
-		}
-		else
-			speed[i] = 0.0;
-
-		// printf("s[%d]=%d-ps[%d]=%d => d[%d]%d ",i, sensors[i], i, prev_sensors[i], i, diff[i]); 
-		// printf(" s[%d]:%.2f | ",i, speed[i]);
-	}
-	printf("\n");
-	float mean = get_mean_normalized_f(speed, 8, 0.0, (MAX_DIST/TIME)); // get mean of speed for all sensors
-	printf("mean: %f\n", mean);
+int speed_damage(model_t *m){
+	int i, age = history_count(&m->history) < SPEED_FRAMES ? history_count(&m->history)-1 : SPEED_FRAMES-1;
+	float v, scale = 1e6f/(m->params->max_dist-m->params->min_dist); // value per us to fraction of range per s
+	// mean of one frame speeds, updated by get_sensors(), gates the detector, each sensor is then
+	// checked with its velocity over SPEED_FRAMES frames of history
+	float mean = m->pre.speed_mean; // mean of speed for all sensors
 	// TODO : FIX ERROR HERE
-	if(mean > 0.05*(1.0/8.0)){ // if mean speed is superior as 5% of max speed
+	if(mean > m->params->speed_damage_mean*(1.0/8.0)){ // if mean speed is superior as 5% of max speed
 		for(i=0; i<8; i++){
-			if(speed[i]>0.05) // if for ith sensor speed is greater than 5% of max speed
-				induce_damage(speed[i]); // induce damage
+			v = history_velocity(&m->history, i, age)*scale;
+			if(v>m->params->speed_damage) // if for ith sensor speed is greater than 5% of max speed
+				induce_damage(m, v); // induce damage
 		}
 		return 1; // there is damage
 	}
@@ -555,348 +436,539 @@ int speed_damage(void){
 /** ****************************************************************
  * check if damage
  * 
+ * @param m model context
  * @return 0 when not, 1 when yes
  * @brief function that check if there is damage based on two types of damage 
+ * @note detectors are gated by the masks of get_sensors(): speed_damage() needs a sensor speed,
+ * circ_damage() a near and moving sensor, or circular speeds of previous tick to clear, skipped detectors give no damage
 ***************************************************************** */
-int check_if_damage(void){
-	if(circ_damage() || speed_damage())
-		return 1;
-	return 0;
+int check_if_damage(model_t *m){
+	int damage = 0;
+	unsigned int scratch = m->pre.circ_near & m->ir_moving;
+	if(scratch == 0 && m->pre.delta == 0 && !m->circ_active){
+		m->damage_skips++; // idle frame
+		return 0;
+	}
+	if(scratch || m->circ_active)
+		damage |= circ_damage(m);
+	if(m->pre.delta)
+		damage |= speed_damage(m);
+	return damage;
 }
 
 /** ****************************************************************
  * Update internal variables
  * 
+ * @param m model context
  * @return 0 when ok
  * @param loopstart, an int set to 1 when it's loop start
  * @brief function that update the internal variables, compute deficits, cues and motivation 
+ * @note deficits, cues and motivations are only computed for changed inputs (see motivations())
 ***************************************************************** */
-int update_vars(int loopstart){
+int update_vars(model_t *m, int loopstart){
 	if(loopstart){
-		decrease_physoligical_variables();
-		get_sensors();
-		check_if_damage();
+		decrease_physoligical_variables(m);
+		PROBE_BEGIN(PROBE_SENSORS);
+		get_sensors(m);
+		PROBE_END(PROBE_SENSORS);
+		PROBE_BEGIN(PROBE_DAMAGE);
+		check_if_damage(m);
+		apply_damage(m);
+		PROBE_END(PROBE_DAMAGE);
 	}
-	compute_deficit();
-	compute_cues();
-	compute_motivations();
+	PROBE_BEGIN(PROBE_UPDATE);
+	motivations(m);
+	PROBE_END(PROBE_UPDATE);
 	return 0;
 }
 
 /** ****************************************************************
- * Print internal variables
+ * Eat function
  * 
+ * @param m model context
  * @return 0 when ok
- * @brief function that print internal variables 
-***************************************************************** */
-int print_vars(){
-    system("clear"); /*clear output screen*/
-	printf("************************MODEL UPDATE**************************\n");
-	printf("**************************************************************\n");
-	printf("energy= %.2f | tegument = %.2f | integrity = %.2f\n", var_energy*100.0, var_tegument*100.0, var_integrity*100.0);
-	printf("**************************************************************\n");
-	printf("def= %.2f | def = %.2f | def = %.2f\n", def_energy*100.0, def_tegument*100.0, def_integrity*100.0);
-	printf("**************************************************************\n");
-	printf("cue= %.2f | cue = %.2f | cue = %.2f\n", cue_energy*100.0, cue_tegument*100, cue_integrity*100.0);
-	printf("**************************************************************\n");
-	printf("mot= %.2f | mot = %.2f | mot = %.2f\n", mot_energy*100.0, mot_tegument*100.0, mot_integrity*100.0);
-	printf("**************************************************************\n");
-
+ * @brief function that increase physiological energy variable 
+***************************************************************** */
+int eat(model_t *m){
+	m->var[NEED_ENERGY] += m->params->eat_gain;
+	if(m->var[NEED_ENERGY] > HOMEO_ONE)
+		m->var[NEED_ENERGY] = HOMEO_ONE;
+	m->var_dirty |= 1u << NEED_ENERGY;
 	return 0;
 }
 
 /** ****************************************************************
- * Print sensors
+ * Food seeking behavior
  * 
+ * @param m model context
  * @return 0 when ok
- * @brief function that print sensor values 
+ * @brief function that select send mootor control for food seeking 
 ***************************************************************** */
-int print_sensors(void){
-	int i;
-	printf("************************SENSOR VALUES*************************\n");
-	printf("**************************************************************\n");
-	printf("\t\t");
-	for (i=0; i<8; i++){
-		printf(" %d ", sensors[i]);
-	}
-	printf("\n**************************************************************\n");
+int seek_food(model_t *m){
+	move(m, 0.8,0.8);
 	return 0;
 }
 
 /** ****************************************************************
- * Print sensor history
+ * Energy behavioral group
  * 
+ * @param m model context
  * @return 0 when ok
- * @brief function that print previous sensor values 
+ * @brief function that select sub-behavioral group for energy 
 ***************************************************************** */
-int print_sensors_history(void){
-	int i;
-	printf("************************HIST VALUES*************************\n");
-	printf("**************************************************************\n");
-	printf("\t\t");
-	for (i=0; i<8; i++){
-		printf(" %d ", prev_sensors[i]);
-	}
-	printf("\n**************************************************************\n");
+int energy_behavioral_group(model_t *m){
+	int can_eat = m->perception.food; // 0 without fusion
+	if(can_eat)
+		eat(m);
+	seek_food(m);
 	return 0;
 }
 
 /** ****************************************************************
- * Print sensor history and acutal diff
+ * TODO ADD LEDS
+ * Grooming animation
  * 
+ * @param m model context
  * @return 0 when ok
- * @brief function that print diff between actual and previous sensor data 
+ * @brief function that make a grooming animation 
+ * @note non blocking, wiggle primitive runs over the next ticks
 ***************************************************************** */
-int print_sensors_diff(void){
-	int i;
-	printf("************************DIFF VALUES*************************\n");
-	printf("**************************************************************\n");
-	printf("\t\t");
-	for (i=0; i<8; i++){
-		printf(" %d ", sensors[i]-prev_sensors[i]);
-	}
-	printf("\n**************************************************************\n");
+int groom_animation(model_t *m){
+	motors_play(&m->motors, &primitive_wiggle); // wiggle is advanced by the model loop
 	return 0;
 }
 
-
 /** ****************************************************************
- * Print sensor speed
+ * Grooming spot seeking behavior
  * 
+ * @param m model context
  * @return 0 when ok
- * @brief function that print speed table 
+ * @brief function that select send mootor control for groooming spot seeking 
 ***************************************************************** */
-int print_sensors_speed(void){
-	int i;
-	printf("*************************SPEED VALUES*************************\n");
-	printf("**************************************************************\n");
-	printf("\t");
-	for (i=0; i<8; i++){
-		printf(" %.2f ", speed[i]);
-	}
-	printf("\n**************************************************************\n");
+int seek_grooming_spot(model_t *m){
+	move(m, 0.8,0.8);
 	return 0;
 }
 
 /** ****************************************************************
- * Print sensor history and acutal diff
+ * Groom function
  * 
+ * @param m model context
  * @return 0 when ok
- * @brief function that print diff between actual and previous sensor data 
+ * @brief function that increase physiological tegument variable 
 ***************************************************************** */
-int print_sensors_circ_speed(void){
-	int i;
-	printf("*********************CIRC SPEED VALUES************************\n");
-	printf("**************************************************************\n");
-	printf("\t\t");
-	for (i=0; i<7; i++){
-		printf(" %.2f ", circ_speed[i]);
-	}
-	printf("\n**************************************************************\n");
+int groom(model_t *m){
+	m->var[NEED_TEGUMENT] += m->params->groom_gain;
+	if(m->var[NEED_TEGUMENT] > HOMEO_ONE)
+		m->var[NEED_TEGUMENT] = HOMEO_ONE;
+	m->var_dirty |= 1u << NEED_TEGUMENT;
+	groom_animation(m);
 	return 0;
 }
 
-
 /** ****************************************************************
- * Clean sensors infos print
+ * Tegument behavioral group
  * 
+ * @param m model context
  * @return 0 when ok
- * @brief function that print previous  and actual sensor values 
-***************************************************************** */
-int print_clean_sensor(void){
-	print_sensors_history();
-	print_sensors();
-	print_sensors_diff();
-	print_sensors_speed();
-	print_sensors_circ_speed();
+ * @brief function that select sub-behavioral group for tegument 
+***************************************************************** */
+int tegument_behavioral_group(model_t *m){
+	int can_groom = m->perception.grooming; // 0 without fusion
+	if(can_groom)
+		groom(m);
+	seek_grooming_spot(m);
 	return 0;
 }
 
 /** ****************************************************************
- * Eat function
+ * Danger avoidance behavior
  * 
+ * @param m model context
  * @return 0 when ok
- * @brief function that increase physiological energy variable 
+ * @brief function that give motor speed avoidance control 
+ * @note Braitenberg vehicle, weights are the avoid parameters, clamped sensors are normalized with (max_dist-min_dist)/2
 ***************************************************************** */
-int eat(void){
-	var_energy += 0.05;
+int avoid(model_t *m){
+	float speed[2];
+	braitenberg_eval(&m->params->avoid, m->sensors, 2.0f/(m->params->max_dist - m->params->min_dist), speed);
+	move(m, speed[0], speed[1]);
 	return 0;
 }
 
 /** ****************************************************************
- * Food seeking behavior
+ * Integrity behavioral group
  * 
+ * @param m model context
  * @return 0 when ok
- * @brief function that select send mootor control for food seeking 
+ * @brief function that select sub-behavioral group for integrity 
 ***************************************************************** */
-int seek_food(void){
-	move(0.8,0.8);
+int integrity_behavioral_group(model_t *m){
+	motors_cancel(&m->motors); // avoidance has priority on animations
+	avoid(m);
 	return 0;
 }
 
 /** ****************************************************************
- * Energy behavioral group
+ * Behaviour table
+ *
+ * @brief cue function and behavioral group of each need, decays and constant cues are parameters
+***************************************************************** */
+const behaviour_t behaviours[NEED_COUNT] = {
+	[NEED_ENERGY] = { NULL, &energy_behavioral_group },
+	[NEED_TEGUMENT] = { NULL, &tegument_behavioral_group },
+	[NEED_INTEGRITY] = { &integrity_cue, &integrity_behavioral_group },
+};
+
+/** ****************************************************************
+ * Select behavioral group to compute speed
  * 
+ * @param m model context
  * @return 0 when ok
- * @brief function that select sub-behavioral group for energy 
+ * @param bhv the selected behavioral group (need index)
+ * @brief function that call behavioral group of behaviour table to compute robot's speed
+ * @note robot is stopped if bhv is not a need
 ***************************************************************** */
-int energy_behavioral_group(void){
-	int can_eat = 0;
-	if(can_eat)
-		eat();
-	seek_food();
-	return 0;
+int compute_speed(model_t *m, int bhv){
+	if(bhv < 0 || bhv >= NEED_COUNT)
+		return move(m, 0.0, 0.0); // Error -> stop robot
+	return behaviours[bhv].group(m);
 }
 
 /** ****************************************************************
- * TODO ADD LEDS
- * Grooming animation
+ * Record tick telemetry
  * 
- * @return 0 when ok
- * @brief function that make a grooming animation 
+ * @param m model context
+ * @param behaviour selected behavioral group
+ * @return 0 when ok, -1 if record is dropped
+ * @brief function that write model state in telemetry ring
 ***************************************************************** */
-int groom_animation(void){
-	move(-1.0,1.0);
-	usleep(2*TIME);
-	move(1.0,-1.0);
-	usleep(2*TIME);
+int record_tick(model_t *m, int behaviour){
+	int i;
+	telemetry_record_t *r;
+	if(!m->telemetry)
+		return 0;
+	r = telemetry_reserve();
+	if(r == NULL)
+		return -1;
+	r->t_ns = m->sensors_t_ns;
+	r->tick = m->tick;
+	r->behaviour = behaviour;
+	for(i=0; i<NEED_COUNT; i++){
+		r->var[i] = homeo_to_float(m->var[i]);
+		r->def[i] = homeo_to_float(m->def[i]);
+		r->cue[i] = homeo_to_float(m->cue[i]);
+		r->mot[i] = homeo_to_float(m->mot[i]);
+	}
+	for(i=0; i<8; i++){
+		r->sensors[i] = m->sensors[i];
+		r->speed[i] = m->speed[i];
+	}
+	for(i=0; i<7; i++)
+		r->circ_speed[i] = m->circ_speed[i];
+	r->left_speed = m->left_speed;
+	r->right_speed = m->right_speed;
+	r->dt = m->tick_dt;
+	r->us_t_ns = m->frame.us_t_ns;
+	for(i=0; i<8; i++)
+		r->ir[i] = m->frame.ir[i];
+	for(i=0; i<GROUND_CHANNELS; i++)
+		r->ground[i] = m->frame.ground[i];
+	for(i=0; i<HAL_US_CHANNELS; i++)
+		r->us[i] = m->frame.us[i];
+	for(i=0; i<TELEMETRY_STAGES; i++)
+		r->stage_ns[i] = probe_last_ns(PROBE_TICK+i);
+	r->battery = m->frame.battery;
+	r->current = m->frame.current;
+	r->tier = m->rate.tier;
+	for(i=0; i<TELEMETRY_TIERS; i++)
+		r->tier_ms[i] = m->rate.tier_ns[i]/1000000ULL;
+	telemetry_commit();
 	return 0;
 }
 
 /** ****************************************************************
- * Grooming spot seeking behavior
+ * Publish tick state
  * 
+ * @param m model context
+ * @param behaviour selected behavioral group
  * @return 0 when ok
- * @brief function that select send mootor control for groooming spot seeking 
+ * @brief function that publish model state of the tick for readers of other threads
+ * @note readers use snapshot_read(&m->state, ...), the model never waits for them
 ***************************************************************** */
-int seek_grooming_spot(void){
-	move(0.8,0.8);
-	return 0;
+int publish_tick(model_t *m, int behaviour){
+	snapshot_t s;
+	int i;
+	s.t_ns = m->sensors_t_ns;
+	s.tick = m->tick;
+	s.behaviour = behaviour;
+	for(i=0; i<NEED_COUNT; i++){
+		s.var[i] = homeo_to_float(m->var[i]);
+		s.def[i] = homeo_to_float(m->def[i]);
+		s.cue[i] = homeo_to_float(m->cue[i]);
+		s.mot[i] = homeo_to_float(m->mot[i]);
+	}
+	s.left_speed = m->left_speed;
+	s.right_speed = m->right_speed;
+	for(i=0; i<8; i++)
+		s.sensors[i] = m->sensors[i];
+	return snapshot_publish(&m->state, &s);
 }
 
 /** ****************************************************************
- * Groom function
+ * Use a parameter block
  * 
+ * @param m model context
+ * @param p parameter block, published by params.c
  * @return 0 when ok
- * @brief function that increase physiological tegument variable 
+ * @brief function that make the model use a parameter block
+ * @note loop period, motor speed and decays are reset to the values of the block, scaled by the rate tier
 ***************************************************************** */
-int groom(void){
-	var_energy += 0.05;
-	groom_animation();
+int model_set_params(model_t *m, const params_t *p){
+	int i, mult = rate_mult[m->rate.tier];
+	m->params = p;
+	m->tick_period = p->tick_period;
+	m->sched.period_us = p->tick_period*mult; // next deadlines of a running loop
+	m->motors.speed_scale = p->speed;
+	for(i=0; i<NEED_COUNT; i++)
+		m->decay[i] = p->decay[i]*mult;
+	m->cue_dirty = NEED_ALL; // constant cues may have changed
 	return 0;
 }
 
 /** ****************************************************************
- * Tegument behavioral group
+ * Check activity
  * 
- * @return 0 when ok
- * @brief function that select sub-behavioral group for tegument 
+ * @param m model context, after a tick
+ * @return 1 when the tick saw activity, 0 when the robot is quiet
+ * @brief function that tell if the loop must run at its fast rate
+ * @note active when a sensor moves, a sensor is near, a damage detector runs or a motor primitive plays
 ***************************************************************** */
-int tegument_behavioral_group(void){
-	int can_groom = 0;
-	if(can_groom)
-		groom();
-	seek_grooming_spot();
-	return 0;
+int is_active(model_t *m){
+	return m->pre.delta || m->pre.circ_near || m->circ_active
+		|| m->pre.ir_mean > RATE_NEAR || m->motors.primitive != NULL;
 }
 
 /** ****************************************************************
- * Danger avoidance behavior
+ * Adapt loop rate
+ * 
+ * @param m model context, after a tick
+ * @return 1 when the rate changed, 0 otherwise
+ * @brief function that select the rate tier of the next tick from activity and battery
+ * @note tick and acquisition periods are multiplied by the tier, decays too so variables
+ * decrease at the same pace in time, leds are turned off in power saving
+***************************************************************** */
+int model_adapt(model_t *m){
+	int i, old = rate_mult[m->rate.tier];
+	if(!rate_update(&m->rate, is_active(m), m->frame.battery))
+		return 0;
+	for(i=0; i<NEED_COUNT; i++)
+		m->decay[i] = m->decay[i]/old*rate_mult[m->rate.tier]; // multipliers are powers of 2, exact in every numeric policy
+	m->sched.period_us = m->tick_period*rate_mult[m->rate.tier];
+	scheduler_set_period(&m->sched, m->sched.period_us); // a faster tier does not wait the end of a slow period
+	acquisition_set_period(&m->acquisition, m->acquisition_period*rate_mult[m->rate.tier]);
+	if(m->rate.tier == RATE_SAVE && m->leds)
+		turn_off_leds();
+	return 1;
+}
+
+/** ****************************************************************
+ * Init model context
  * 
+ * @param m model context
+ * @param robot robot device
  * @return 0 when ok
- * @brief function that give motor speed avoidance control 
+ * @brief function that set initial physiological state and default parameters
+ * @note leds and telemetry are disabled, set m->leds and m->telemetry to use them
 ***************************************************************** */
-int avoid(void){
-	int min = 0, max = 1023;
-	// Normalization of sensors
+int model_init(model_t *m, hal_dev_t *robot){
 	int i;
-	float normalized_sensors[8];
-	for(i=0;i<8;i++){
-		normalized_sensors[i] = (sensors[i]-min)/(max-min);
-	}
-
-	//TODO 
-	//Braitenberg avoidance
-	float weight_l[8] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
-	float weight_r[8] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
-
-	for(i=0;i<8; i++){
-		left_speed += weight_l[i]*normalized_sensors[i];
-		right_speed += weight_r[i]*normalized_sensors[i];
+	memset(m, 0, sizeof(*m));
+	m->robot = robot;
+	motors_init(&m->motors, robot, params_get()->speed);
+	model_set_params(m, params_get());
+	m->acquisition_period = ACQ_PERIOD;
+	m->tick_dt = m->tick_period;
+	for(i=0; i<NEED_COUNT; i++){
+		m->var[i] = HOMEO_ONE;
+		m->def[i] = HOMEO_ONE;
+		m->cue[i] = HOMEO_ONE;
+		m->mot[i] = HOMEO_ONE;
 	}
-	left_speed /= 8;
-	right_speed /= 8;
-
-	move(left_speed, right_speed);
-
+	m->var_dirty = NEED_ALL;
+	m->cue_dirty = NEED_ALL;
+	m->mot_dirty = NEED_ALL;
+	history_init(&m->history);
+	m->sensors = history_next(&m->history)->v;
+	m->prev_sensors = history_get(&m->history, 0)->v;
+	m->decisions = 2166136261u;
+	m->cue_alpha = 1.0;
+	snapshot_init(&m->state);
 	return 0;
 }
 
 /** ****************************************************************
- * Integrity behavioral group
+ * Prime model
  * 
+ * @param m model context, statistics initialised
  * @return 0 when ok
- * @brief function that select sub-behavioral group for integrity 
+ * @brief function that read the first frame, which gives history to the first tick
+ * @note first frame is recorded in telemetry as tick 0, so a replay sees the same frames
 ***************************************************************** */
-int integrity_behavioral_group(void){
-	avoid();
+int model_prime(model_t *m){
+	get_sensors(m);
+	memset(m->speed, 0, sizeof(m->speed)); // first frame has no history
+	record_tick(m, -1);
+	publish_tick(m, -1);
 	return 0;
 }
 
 /** ****************************************************************
- * Select behavioral group to compute speed
+ * Model tick
  * 
- * @return 0 when ok
- * @param bhv the selected behavioral group
- * @brief function that select behavioral grroup to compute robot's speed based on input 
- * @note 1 if energy, 2 if tegument, 3 if integrity, -1 if error
-***************************************************************** */
-int compute_speed(int bhv){
-	switch(bhv){
-		case 1 : // energy behaviorral group
-			energy_behavioral_group();
-			break;
-		case 2 : // tegument behaviorral group
-			tegument_behavioral_group();
-			break;
-		case 3 : // integrity behaviorral group
-			integrity_behavioral_group();
-			break;
-		case -1 : // Error -> stop robot
-		default :
-			left_speed = 0.0;
-			right_speed = 0.0;
-			break;
+ * @param m model context
+ * @return selected behavioral group
+ * @brief function that run one decision tick, from sensors to motor command
+ * @note sensors are read from acquisition, motor command is written through motors layer
+***************************************************************** */
+int model_tick(model_t *m){
+	int behaviral;
+	m->tick++;
+	PROBE_BEGIN(PROBE_TICK);
+	update_vars(m, 1);
+	PROBE_BEGIN(PROBE_SPEED);
+	behaviral = winner_takes_all(motivations(m), NEED_COUNT);
+	compute_speed(m, behaviral);
+	PROBE_END(PROBE_SPEED);
+	if(m->tick > 1 && behaviral != m->behaviour){
+		m->switches++;
+		if(m->fleet)
+			agent_event(m, FLEET_SWITCH, m->behaviour, behaviral);
 	}
-	return 0;
+	m->behaviour = behaviral;
+	m->behaviour_ticks[behaviral]++;
+	m->decisions = (m->decisions ^ (uint8_t)behaviral) * 16777619u;
+	PROBE_BEGIN(PROBE_MOVE);
+	motors_advance(&m->motors, m->sched.last_ns); // playing primitive overrides moves of the tick
+	motors_commit(&m->motors); // single bus write for all moves of the tick
+	PROBE_END(PROBE_MOVE);
+	PROBE_BEGIN(PROBE_TELEMETRY);
+	record_tick(m, behaviral);
+	publish_tick(m, behaviral);
+	PROBE_END(PROBE_TELEMETRY);
+	get_sensors_history(m);
+	PROBE_END(PROBE_TICK);
+	return behaviral;
+}
+
+/** ****************************************************************
+ * Run model loop
+ * 
+ * @param m model context
+ * @param max_ticks maximum number of ticks, 0 to run until death
+ * @return number of ticks done, -1 if error
+ * @brief function that run the decision loop until a physiological variable reaches 0
+ * @note loop runs at tick_period on absolute deadlines, tick_dt is the measured period
+***************************************************************** */
+int model_run(model_t *m, uint32_t max_ticks){
+	if(scheduler_init(&m->sched, m->tick_period, m->robot) < 0)
+		return -1;
+	if(stats_init(&m->ir_stats, m->cue_alpha) < 0)
+		return -1;
+	if(acquisition_start(&m->acquisition, m->robot, m->acquisition_period, m->fusion ? ACQ_US_DIV : 0) < 0)
+		return -1;
+	model_prime(m);
+	rt_loop_start();
+	while(is_alive(m) && (max_ticks == 0 || m->tick < max_ticks)){
+		if(params_poll())
+			model_set_params(m, params_get()); // between ticks, a tick sees a single parameter block
+		model_tick(m);
+		probe_poll();
+		model_adapt(m);
+		scheduler_wait(&m->sched); // wait next deadline
+		m->tick_dt = m->sched.dt;
+		rate_account(&m->rate, m->tick_dt);
+	}
+	acquisition_stop(&m->acquisition);
+	if(m->fleet)
+		agent_event(m, FLEET_DEATH, model_death_cause(m), 0);
+	return m->tick;
 }
 
 /** ****************************************************************
  * Simple robot model
  * 
- * @return 1 is ok, 0 if error
+ * @param m model context
+ * @return 0 is ok, -1 if error
  * @brief Robot model based on our work
+ * @note model state is recorded in telemetry each tick, console view is done by telemetry writer
+***************************************************************** */
+int model(model_t *m){
+	int r;
+	probe_install_signal(); // SIGUSR1 dumps probes
+	// bus, LED and agent threads are already running, the others are started after and set their own class
+	if(m->rt && (rt_start() < 0 || bus_thread_class(RT_ACQUISITION) < 0 || leds_thread_class(RT_BACKGROUND) < 0
+		|| agent_thread_class(RT_BACKGROUND) < 0))
+		return -1;
+	if(telemetry_start(telemetry_path, telemetry_udp, telemetry_view) < 0)
+		return -1;
+	m->telemetry = 1;
+	r = model_run(m, 0);
+	stop_moving(m);
+	telemetry_stop();
+	scheduler_print_stats(&m->sched);
+	rt_print_stats();
+	rate_print_stats(&m->rate);
+	printf("Damage: detectors skipped on %lu of %u ticks\n", m->damage_skips, m->tick);
+	probe_dump();
+	death_animation();
+	return r < 0 ? -1 : 0;
+}
+
+/** ****************************************************************
+ * Parse model options
+ * 
+ * @param m model context
+ * @param argc number of options
+ * @param argv options, kept by reference for file names
+ * @return 0 when ok, -1 if error
+ * @brief function that set model context and telemetry from model options
+ * @note options : -t period_us for loop period, -l file for telemetry file, -v [period_ms] for console view,
+ * -a alpha for EWMA smoothing of integrity cue, -f for ground and ultrasound fusion,
+ * -u host:port to stream telemetry to a monitoring host, -c file for parameter file (reloaded on SIGHUP),
+ * --rt for real-time mode (locked memory, SCHED_FIFO control thread, see rt.h), -e for adaptive loop rate (see rate.h)
+ * @note options after -c override the parameter file until it is reloaded
 ***************************************************************** */
-int model(void){
-	int iterator = 0;
-	get_sensors();
-	while((var_energy>0) && (var_tegument>0) && (var_integrity>0)){
-		iterator++;
-		update_vars(1);
-		int behaviral = winner_takes_all(mot_energy,mot_tegument,mot_integrity);
-		compute_speed(behaviral);
-		move(left_speed,right_speed);
-
-		if(iterator==3){
-			print_vars();
-			print_clean_sensor();
-			iterator=0;
+int model_options(model_t *m, int argc, char *argv[]){
+	int i;
+	for(i=0; i<argc; i++){
+		if(strcmp(argv[i],"-c")==0 && i+1<argc){
+			if(params_start(argv[++i]) < 0)
+				return -1;
+			model_set_params(m, params_get());
+		}
+		else if(strcmp(argv[i],"-t")==0 && i+1<argc)
+			m->tick_period = atol(argv[++i]);
+		else if(strcmp(argv[i],"-f")==0)
+			m->fusion = 1;
+		else if(strcmp(argv[i],"--rt")==0)
+			m->rt = 1;
+		else if(strcmp(argv[i],"-e")==0)
+			m->rate.enabled = 1;
+		else if(strcmp(argv[i],"-a")==0 && i+1<argc)
+			m->cue_alpha = atof(argv[++i]);
+		else if(strcmp(argv[i],"-l")==0 && i+1<argc)
+			telemetry_path = argv[++i];
+		else if(strcmp(argv[i],"-u")==0 && i+1<argc)
+			telemetry_udp = argv[++i];
+		else if(strcmp(argv[i],"-v")==0){
+			telemetry_view = 500;
+			if(i+1<argc && argv[i+1][0]!='-')
+				telemetry_view = atol(argv[++i]);
 		}
-		get_sensors_history();
-		usleep(TIME); // wait TIME
 	}
-	stop_moving();
-	death_animation();
+	if(m->fusion && m->robot != NULL)
+		bus_activate_us(m->robot, HAL_US_ALL); // ultrasounds are read by acquisition thread
 	return 0;
 }
 
@@ -907,46 +979,69 @@ int model(void){
  * @param argc an int input non used on this function
  * @param argv a string input used to say if you want to run model or keyboard control
  * @return : none
- * @note type run for keyboard control
+ * @note -r [options] for keyboard control with sensing and telemetry (see teleop.h), -m [options] for model (see model_options()), -g [port] for fleet agent,
+ * -p telemetry.bin [-o diff.csv] [options] for replay, -k [-n ops] [-p telemetry.bin] [-o bench.csv] for kernel
+ * benchmarks, -b for batch experiments (host build only)
 ***************************************************************** */
 int main(int argc, char *argv[]){
-	// Set the libkhepera debug level - recommended for development.
-	kb_set_debug_level(2);
+	int r = 0;
+	hal_dev_t *robot;
+	model_t ctx, *m = &ctx;
+
+#ifdef MODEL_SIM
+	// batch experiments open their own simulated robots
+	if(argc > 1 && strcmp(argv[1],"-b")==0)
+		return runner_main(argc, argv);
+#endif
+
+	// replay feeds recorded frames, no robot is opened
+	if(argc > 1 && strcmp(argv[1],"-p")==0)
+		return replay_main(argc, argv);
+
+	// benchmarks run kernels on frames in memory, no robot is opened
+	if(argc > 1 && strcmp(argv[1],"-k")==0)
+		return bench_main(argc, argv);
 
 	printf("Running...\n\n");
 
-	// Init the Khepera library
-	if(kb_init(argc, argv) < 0)
-	{
-		printf("ERROR: kb_init error (no privs? try sudo)\n");
+	// Init the robot (libkhepera and K-Net device, or simulation)
+	robot = hal_open(argc, argv);
+	if(robot == NULL)
 		return -1;
-	}
+	model_init(m, robot);
 
-	// open K-Net device and store the handle
-	dsPic  = knet_open("Khepera4:dsPic", KNET_BUS_I2C, 0, NULL);
-	if (dsPic==NULL)
-	{
-		printf("ERROR: could not initiate comms with Kh4 dsPic\n");
+	// bus owner serves every access to the dsPic from now on
+	if(bus_start(robot) < 0)
 		return -1;
-	}
 
 	// mute Ultrasounds
-	kh4_activate_us(0,dsPic);
+	bus_activate_us(robot, 0);
 
-	int r = 0;
+	// LED worker owns the leds from now on
+	if(leds_start(robot) < 0)
+		return -1;
+	m->leds = 1;
 
-	if(strcmp(argv[1],"-r")==0){
-		r = display_battery();
-		r = run();
+	if(argc > 1 && strcmp(argv[1],"-r")==0){
+		display_battery(m);
+		r = model_options(m, argc-2, argv+2);
+		if(r == 0)
+			r = teleop_main(m);
 	}
-	else if(strcmp(argv[1],"-m")==0){
-		r = model();
+	else if(argc > 1 && strcmp(argv[1],"-m")==0){
+		r = model_options(m, argc-2, argv+2);
+		if(r == 0)
+			r = model(m);
 	}
+	else if(argc > 1 && strcmp(argv[1],"-g")==0)
+		r = agent_main(m, argc > 2 ? atoi(argv[2]) : FLEET_PORT);
 	else
-		r = stop_moving();
+		r = stop_moving(m);
 
 
-	knet_close(dsPic);
+	leds_stop(); // wait for the end of animations
+	bus_stop(); // send pending writes
+	hal_close(robot);
 
 	return r;
 }
@@ -0,0 +1,146 @@
+/** ****************************************************************
+ * @file model.h
+ * @brief Simple model for decision making in a TRP with Khepera IV robot.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * Model state is kept in a per-episode context, so several episodes can
+ * run concurrently (batch runner on the simulated robot).
+***************************************************************** */
+#ifndef MODEL_H
+#define MODEL_H
+
+#include <stdint.h>
+#include "hal.h"
+#include "acquisition.h"
+#include "motors.h"
+#include "scheduler.h"
+#include "preprocess.h"
+#include "numeric.h"
+#include "needs.h"
+#include "stats.h"
+#include "history.h"
+#include "fusion.h"
+#include "params.h"
+#include "snapshot.h"
+#include "rate.h"
+
+#define MAXBUFFERSIZE 128 ///< Buffer size for robot communication
+#define SPEED_FRAMES 4 ///< frame periods of the sensor velocities of speed_damage(), at most HISTORY_DEPTH-1
+
+/** ****************************************************************
+ * Damage accumulator
+ *
+ * @brief damage contributions collected during a tick
+***************************************************************** */
+typedef struct {
+	float level; ///< integrity loss accumulated since last apply
+	int hits; ///< number of non null contributions since last apply
+} damage_acc_t;
+
+/** ****************************************************************
+ * Model context
+ *
+ * @brief whole state of one model episode
+***************************************************************** */
+typedef struct {
+	hal_dev_t *robot; ///< robot device (libkhepera dsPic or simulation)
+	const params_t *params; ///< parameters in use, replaced between ticks on reload
+	motors_t motors; ///< motor command layer
+	acquisition_t acquisition; ///< asynchronous sensor acquisition
+	long acquisition_period; ///< period of sensor acquisition (in us)
+	scheduler_t sched; ///< model loop scheduler
+	long tick_period; ///< period of the model loop (in us), tick_period parameter by default
+	float tick_dt; ///< measured duration of the last model tick (in us)
+
+	float left_speed; ///< speed of left motor
+	float right_speed; ///< speed of right motor
+
+	homeo_t var[NEED_COUNT]; ///< physological variables
+	homeo_t def[NEED_COUNT]; ///< deficits
+	homeo_t cue[NEED_COUNT]; ///< cues
+	homeo_t mot[NEED_COUNT]; ///< motivations
+	homeo_param_t decay[NEED_COUNT]; ///< decrease of physological variables per tick, double in legacy policy
+	unsigned int var_dirty; ///< needs whose variable changed since their deficit was computed
+	unsigned int cue_dirty; ///< needs whose cue source (frame or parameter) changed since their cue was computed
+	unsigned int mot_dirty; ///< needs whose deficit or cue changed since their motivation was computed
+
+	history_t history; ///< ring of last sensors values, actual tick frame included
+	int *sensors; ///< actual sensors values, frame of actual tick in history
+	const int *prev_sensors; ///< previous sensors values, newest committed frame of history
+	uint64_t sensors_t_ns; ///< acquisition time of actual sensors values (in ns)
+	ir_frame_t frame; ///< raw frame of actual sensors values
+	preprocess_t pre; ///< means and thresholds of actual sensors values
+	stats_t ir_stats; ///< sliding window statistics of sensors values
+	unsigned int ir_moving; ///< bit i set when sensor i moved by more than 5% of max_dist-min_dist over the stats window
+	float cue_alpha; ///< EWMA weight of a new frame for integrity cue, 1 for no smoothing
+	int fusion; ///< 1 when ground sensors and ultrasounds are fused in perception
+	perception_t perception; ///< resources and nearest obstacle, only updated with fusion
+
+	float speed[8]; ///< table for speeed based on IR sensor values
+	float circ_speed[7]; ///< table for circular speeed based on IR sensor values (size is n-1 because of circular speeed)
+
+	damage_acc_t damage_acc; ///< damage accumulated during actual tick
+	int circ_active; ///< 1 when a circular speed of last circ_damage() is not 0, it runs on next tick to clear them
+	unsigned long damage_skips; ///< ticks whose damage detectors were skipped
+
+	int leds; ///< 1 when LED worker animations are requested
+	int telemetry; ///< 1 when ticks are recorded in telemetry
+	int fleet; ///< 1 when events are reported to the fleet coordinator
+	int rt; ///< 1 when the loop runs in real-time mode (see rt.h)
+	rate_t rate; ///< adaptive loop rate, fixed unless rate.enabled
+	snapshot_pub_t state; ///< state of the last tick, published for readers of other threads
+
+	uint32_t tick; ///< ticks done
+	int behaviour; ///< last selected behavioral group (need index)
+	unsigned long switches; ///< number of behavioral group changes
+	unsigned long behaviour_ticks[NEED_COUNT]; ///< ticks spent in each behavioral group
+	uint32_t decisions; ///< FNV-1a digest of the behavioral group of each tick
+} model_t;
+
+int model_init(model_t *m, hal_dev_t *robot);
+int model_prime(model_t *m);
+int model_tick(model_t *m);
+int model_run(model_t *m, uint32_t max_ticks);
+int model(model_t *m);
+int model_options(model_t *m, int argc, char *argv[]);
+int model_death_cause(const model_t *m);
+int model_set_params(model_t *m, const params_t *p);
+int model_adapt(model_t *m);
+int move(model_t *m, float motor_left, float motor_right);
+int stop_moving(model_t *m);
+int record_tick(model_t *m, int behaviour);
+int publish_tick(model_t *m, int behaviour);
+
+extern const char *telemetry_path; ///< binary telemetry file, set by model_options()
+extern long telemetry_view; ///< console view period (in ms), 0 if disabled
+extern const char *telemetry_udp; ///< monitoring host as host:port, NULL if not streamed
+
+// tick stages, called by model_tick() and benchmarks
+int get_sensors(model_t *m);
+int get_sensors_history(model_t *m);
+int circ_damage(model_t *m);
+int speed_damage(model_t *m);
+int check_if_damage(model_t *m);
+int apply_damage(model_t *m);
+int compute_deficit(model_t *m);
+int compute_cues(model_t *m);
+int compute_motivations(model_t *m);
+int update_vars(model_t *m, int loopstart);
+const homeo_t *motivations(model_t *m);
+/** ****************************************************************
+ * Behavioral group
+ *
+ * @brief cue and behaviour of a need, indexed by need
+***************************************************************** */
+typedef struct {
+	homeo_t (*cue_fn)(model_t *m); ///< cue computed from perception, NULL for constant cue parameter
+	int (*group)(model_t *m); ///< behavioral group giving motor commands
+} behaviour_t;
+
+extern const behaviour_t behaviours[NEED_COUNT];
+
+int winner_takes_all(const homeo_t mot[], int n);
+
+#endif
@@ -0,0 +1,203 @@
+/** ****************************************************************
+ * @file motors.c
+ * @brief Motor command layer for Khepera IV.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * Keep track of the motor controller mode and of the last wheel speeds
+ * written on the dsPic, so the bus is only used when a command changes.
+ * Commands requested during a tick are merged into a single write.
+ * Motor primitives (wiggle, turn, forward burst) are timed state machines
+ * advanced once per tick, so they never block the model loop.
+***************************************************************** */
+#include "motors.h"
+#include "bus.h"
+#include <stdio.h>
+
+static const motor_step_t wiggle_steps[] = {
+	{-1.0, 1.0, 200000},
+	{1.0, -1.0, 200000}
+}; ///< wiggle steps
+
+static const motor_step_t turn_steps[] = {
+	{-1.0, 1.0, 600000}
+}; ///< quarter turn steps, about 2.6 rad/s at full speed
+
+static const motor_step_t forward_burst_steps[] = {
+	{1.0, 1.0, 300000}
+}; ///< forward burst steps
+
+const motor_primitive_t primitive_wiggle = {"wiggle", wiggle_steps, sizeof(wiggle_steps)/sizeof(wiggle_steps[0])};
+const motor_primitive_t primitive_turn = {"turn", turn_steps, sizeof(turn_steps)/sizeof(turn_steps[0])};
+const motor_primitive_t primitive_forward_burst = {"forward burst", forward_burst_steps, sizeof(forward_burst_steps)/sizeof(forward_burst_steps[0])};
+
+/** ****************************************************************
+ * Set controller mode
+ *
+ * @param m motor state
+ * @param mode controller mode
+ * @brief function that write controller mode only if it changed
+ * @return 0 when ok
+***************************************************************** */
+static int motors_set_mode(motors_t *m, int mode){
+	if(m->mode == mode)
+		return 0;
+	if(m->dev != NULL)
+		bus_set_mode(m->dev, mode);
+	m->bus_writes++;
+	m->mode = mode;
+	return 0;
+}
+
+/** ****************************************************************
+ * Init motor layer
+ *
+ * @param m motor state
+ * @param dev robot device, NULL to keep commands without writing them (replay)
+ * @param speed_scale wheel speed for a command equal to 1.0
+ * @brief function that init motor layer, controller state is unknown
+ * @return 0 when ok
+***************************************************************** */
+int motors_init(motors_t *m, hal_dev_t *dev, int speed_scale){
+	m->dev = dev;
+	m->speed_scale = speed_scale;
+	m->mode = MOTOR_MODE_UNKNOWN;
+	m->written = 0;
+	m->left = 0;
+	m->right = 0;
+	m->pending = 0;
+	m->bus_writes = 0;
+	m->merged = 0;
+	m->primitive = NULL;
+	return 0;
+}
+
+/** ****************************************************************
+ * Request a motor command
+ *
+ * @param m motor state
+ * @param motor_left speed of robot left wheel in [-1.0,1.0] range
+ * @param motor_right speed of robot right wheel in [-1.0,1.0] range
+ * @brief function that store a command, the last request of a tick wins
+ * @return 0 when ok
+***************************************************************** */
+int motors_request(motors_t *m, float motor_left, float motor_right){
+	if(m->pending)
+		m->merged++;
+	m->pending_left = motor_left*m->speed_scale;
+	m->pending_right = motor_right*m->speed_scale;
+	m->pending = 1;
+	return 0;
+}
+
+/** ****************************************************************
+ * Commit motor command
+ *
+ * @param m motor state
+ * @brief function that write pending command if it differs from dsPic state
+ * @return 0 when ok, -1 if error
+***************************************************************** */
+int motors_commit(motors_t *m){
+	int ret = 0;
+	if(!m->pending)
+		return 0;
+	m->pending = 0;
+	if(m->written && m->mode == HAL_MODE_SPEED && m->left == m->pending_left && m->right == m->pending_right){
+		m->merged++;
+		return 0;
+	}
+	motors_set_mode(m, HAL_MODE_SPEED);
+	m->bus_writes++;
+	if(m->dev != NULL)
+		ret = bus_set_speed(m->dev, m->pending_left, m->pending_right);
+	if(ret < 0){
+		printf("ERROR: Fail on set_speed\n");
+		m->written = 0;
+		return -1;
+	}
+	m->left = m->pending_left;
+	m->right = m->pending_right;
+	m->written = 1;
+	return 0;
+}
+
+/** ****************************************************************
+ * Stop motors
+ *
+ * @param m motor state
+ * @brief function that stop wheels and set controller in idle mode
+ * @return 0 when ok
+***************************************************************** */
+int motors_stop(motors_t *m){
+	m->pending = 0;
+	m->primitive = NULL;
+	motors_set_mode(m, HAL_MODE_SPEED);
+	if(m->dev != NULL)
+		bus_set_speed(m->dev, 0, 0);
+	m->bus_writes++;
+	m->left = 0;
+	m->right = 0;
+	m->written = 1;
+	motors_set_mode(m, HAL_MODE_IDLE);
+	return 0;
+}
+
+/** ****************************************************************
+ * Play a motor primitive
+ *
+ * @param m motor state
+ * @param p primitive to play
+ * @brief function that start a primitive, it begins at next motors_advance()
+ * @return 0 when started, 1 if a primitive is already playing
+***************************************************************** */
+int motors_play(motors_t *m, const motor_primitive_t *p){
+	if(m->primitive != NULL)
+		return 1;
+	m->primitive = p;
+	m->prim_step = 0;
+	m->prim_end_ns = 0;
+	return 0;
+}
+
+/** ****************************************************************
+ * Cancel motor primitive
+ *
+ * @param m motor state
+ * @brief function that stop the primitive being played
+ * @return 0 when ok
+***************************************************************** */
+int motors_cancel(motors_t *m){
+	m->primitive = NULL;
+	return 0;
+}
+
+/** ****************************************************************
+ * Advance motor primitive
+ *
+ * @param m motor state
+ * @param now_ns tick time (monotonic, in ns)
+ * @brief function that move primitive to the step of actual time and request its command
+ * @return 1 if a primitive is playing, 0 otherwise
+ * @note called once per tick before motors_commit(), primitive command overrides moves of the tick
+***************************************************************** */
+int motors_advance(motors_t *m, uint64_t now_ns){
+	const motor_step_t *s;
+	if(m->primitive == NULL)
+		return 0;
+	if(m->prim_end_ns == 0)
+		m->prim_end_ns = now_ns + m->primitive->steps[0].duration_us*1000ULL;
+	while(now_ns >= m->prim_end_ns){
+		m->prim_step++;
+		if(m->prim_step >= m->primitive->n){
+			m->primitive = NULL;
+			return 0;
+		}
+		m->prim_end_ns += m->primitive->steps[m->prim_step].duration_us*1000ULL;
+	}
+	s = &m->primitive->steps[m->prim_step];
+	m->pending_left = s->left*m->speed_scale;
+	m->pending_right = s->right*m->speed_scale;
+	m->pending = 1;
+	return 1;
+}
@@ -0,0 +1,78 @@
+/** ****************************************************************
+ * @file motors.h
+ * @brief Motor command layer for Khepera IV.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * Keep track of the motor controller mode and of the last wheel speeds
+ * written on the dsPic, so the bus is only used when a command changes.
+ * Commands requested during a tick are merged into a single write.
+ * Motor primitives (wiggle, turn, forward burst) are timed state machines
+ * advanced once per tick, so they never block the model loop.
+***************************************************************** */
+#ifndef MOTORS_H
+#define MOTORS_H
+
+#include "hal.h"
+#include <stdint.h>
+
+#define MOTOR_MODE_UNKNOWN -1 ///< controller mode not known yet
+
+/** ****************************************************************
+ * Motor primitive step
+ *
+ * @brief wheel command held during a given time
+***************************************************************** */
+typedef struct {
+	float left; ///< speed of left wheel in [-1.0,1.0] range
+	float right; ///< speed of right wheel in [-1.0,1.0] range
+	long duration_us; ///< duration of the step (in us)
+} motor_step_t;
+
+/** ****************************************************************
+ * Motor primitive
+ *
+ * @brief sequence of timed wheel commands
+***************************************************************** */
+typedef struct {
+	const char *name; ///< primitive name
+	const motor_step_t *steps; ///< steps of the primitive
+	int n; ///< number of steps
+} motor_primitive_t;
+
+extern const motor_primitive_t primitive_wiggle; ///< turn left then right, used for grooming
+extern const motor_primitive_t primitive_turn; ///< quarter turn on the spot
+extern const motor_primitive_t primitive_forward_burst; ///< short full speed forward move
+
+/** ****************************************************************
+ * Motor command state
+ *
+ * @brief cached controller state and pending command
+***************************************************************** */
+typedef struct {
+	hal_dev_t *dev; ///< robot device
+	int speed_scale; ///< wheel speed for a [-1.0,1.0] command equal to 1.0
+	int mode; ///< controller mode written on dsPic, MOTOR_MODE_UNKNOWN if unknown
+	int written; ///< 1 when left and right are the speeds written on dsPic
+	int left; ///< last left wheel speed written
+	int right; ///< last right wheel speed written
+	int pending; ///< 1 when a command is waiting for motors_commit()
+	int pending_left; ///< left wheel speed of pending command
+	int pending_right; ///< right wheel speed of pending command
+	unsigned long bus_writes; ///< number of I2C writes done
+	unsigned long merged; ///< number of commands merged or skipped
+	const motor_primitive_t *primitive; ///< primitive being played, NULL if none
+	int prim_step; ///< actual step of the primitive
+	uint64_t prim_end_ns; ///< end of actual step (monotonic, in ns), 0 if not started
+} motors_t;
+
+int motors_init(motors_t *m, hal_dev_t *dev, int speed_scale);
+int motors_request(motors_t *m, float motor_left, float motor_right);
+int motors_commit(motors_t *m);
+int motors_stop(motors_t *m);
+int motors_play(motors_t *m, const motor_primitive_t *p);
+int motors_cancel(motors_t *m);
+int motors_advance(motors_t *m, uint64_t now_ns);
+
+#endif
@@ -0,0 +1,43 @@
+/** ****************************************************************
+ * @file needs.h
+ * @brief Physiological needs of the model.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * List of physiological variables, each one has a deficit, a cue, a
+ * motivation and a behavioral group. Adding a need is one line here and
+ * one row in the behaviour table of model.c. This header does not depend
+ * on libkhepera, it is shared with telemetry and offline tools.
+***************************************************************** */
+#ifndef NEEDS_H
+#define NEEDS_H
+
+/** ****************************************************************
+ * Need list
+ *
+ * @brief X macro of needs, X(id, name), in selection priority order
+***************************************************************** */
+#define NEED_LIST(X) \
+	X(ENERGY, "energy") \
+	X(TEGUMENT, "tegument") \
+	X(INTEGRITY, "integrity")
+
+#define NEED_ENUM(id, name) NEED_##id,
+#define NEED_NAME(id, name) name,
+
+/** ****************************************************************
+ * Need index
+ *
+ * @brief index of a need in model and telemetry arrays
+***************************************************************** */
+enum {
+	NEED_LIST(NEED_ENUM)
+	NEED_COUNT ///< number of needs
+};
+
+#define NEED_ALL ((1u << NEED_COUNT) - 1) ///< mask of every need, bit i is need i
+
+static const char *const need_names[NEED_COUNT] = { NEED_LIST(NEED_NAME) }; ///< need names, for prints and CSV columns
+
+#endif
@@ -0,0 +1,112 @@
+/** ****************************************************************
+ * @file numeric.h
+ * @brief Numeric policy of the homeostasis engine.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * Physiological variables, deficits, cues and motivations use homeo_t,
+ * selected at compile time with MODEL_NUMERIC:
+ * - NUMERIC_LEGACY float with double literals and decays (original behaviour, double promotion)
+ * - NUMERIC_FLOAT float with float literals only, no double math on VFP
+ * - NUMERIC_FIXED fixed point in int32 (Q8.24 by default), no floating point math
+ *
+ * Q16 is too coarse for per-tick decays (0.004 is off by 0.4%), death
+ * moves by one tick in a quarter of batch episodes, Q8.24 keeps them.
+***************************************************************** */
+#ifndef NUMERIC_H
+#define NUMERIC_H
+
+#include <stdint.h>
+
+#define NUMERIC_LEGACY 0 ///< float values, double literals
+#define NUMERIC_FLOAT 1 ///< float values, float literals
+#define NUMERIC_FIXED 2 ///< fixed point values
+
+#ifndef MODEL_NUMERIC
+#define MODEL_NUMERIC NUMERIC_LEGACY
+#endif
+
+#if MODEL_NUMERIC == NUMERIC_FIXED
+#ifndef HOMEO_SHIFT
+#define HOMEO_SHIFT 24 ///< fractional bits of fixed point values, values stay in [-128, 128[
+#endif
+typedef int32_t homeo_t; ///< fixed point value
+#define HOMEO_ONE (1 << HOMEO_SHIFT) ///< 1.0 in fixed point
+#define HOMEO_SCALE_D ((double)HOMEO_ONE) ///< scale of fixed point values (double, constants only)
+#define HOMEO_SCALE_F ((float)HOMEO_ONE) ///< scale of fixed point values (float)
+#define HOMEO(x) ((homeo_t)((x)*HOMEO_SCALE_D + ((x) >= 0 ? 0.5 : -0.5))) ///< constant in fixed point, folded at compile time
+typedef homeo_t homeo_param_t; ///< runtime parameter standing for a HOMEO() constant
+#define NUMERIC_NAME "fixed point"
+#elif MODEL_NUMERIC == NUMERIC_FLOAT
+typedef float homeo_t; ///< float value
+#define HOMEO_ONE 1.0f ///< 1.0 in float
+#define HOMEO(x) ((homeo_t)(x)) ///< constant in float, cast before any arithmetic
+typedef float homeo_param_t; ///< runtime parameter standing for a HOMEO() constant
+#define NUMERIC_NAME "float"
+#else
+typedef float homeo_t; ///< float value
+#define HOMEO_ONE 1.0 ///< 1.0 in double, promotes expression
+#define HOMEO(x) (x) ///< constant left in double, promotes expression
+typedef double homeo_param_t; ///< runtime parameter standing for a HOMEO() constant, promotes expression
+#define NUMERIC_NAME "legacy float"
+#endif
+
+/** ****************************************************************
+ * Multiply two values
+ *
+ * @param a first value
+ * @param b second value
+ * @brief function that multiply two homeostasis values
+ * @return a*b
+***************************************************************** */
+static inline homeo_t homeo_mul(homeo_t a, homeo_t b){
+#if MODEL_NUMERIC == NUMERIC_FIXED
+	return (homeo_t)(((int64_t)a*b) >> HOMEO_SHIFT);
+#else
+	return a*b;
+#endif
+}
+
+/** ****************************************************************
+ * Convert a parameter
+ *
+ * @param x parameter value read at runtime
+ * @brief function that convert a parameter exactly as HOMEO() converts a literal
+ * @return value
+***************************************************************** */
+static inline homeo_param_t homeo_param(double x){
+	return HOMEO(x);
+}
+
+/** ****************************************************************
+ * Convert from float
+ *
+ * @param f float value
+ * @brief function that convert a float (sensor cue, damage level) to homeostasis value
+ * @return value
+***************************************************************** */
+static inline homeo_t homeo_from_float(float f){
+#if MODEL_NUMERIC == NUMERIC_FIXED
+	return (homeo_t)(f*HOMEO_SCALE_F + (f >= 0 ? 0.5f : -0.5f));
+#else
+	return f;
+#endif
+}
+
+/** ****************************************************************
+ * Convert to float
+ *
+ * @param x homeostasis value
+ * @brief function that convert a homeostasis value to float (telemetry)
+ * @return float value
+***************************************************************** */
+static inline float homeo_to_float(homeo_t x){
+#if MODEL_NUMERIC == NUMERIC_FIXED
+	return x/HOMEO_SCALE_F;
+#else
+	return x;
+#endif
+}
+
+#endif
@@ -0,0 +1,242 @@
+/** ****************************************************************
+ * @file params.c
+ * @brief Runtime parameters of the model.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * Two parameter blocks are used: the published one and a spare one that
+ * is filled on reload, then published with a single pointer store. Only
+ * the model thread reloads, between ticks, so the spare block is never
+ * read while it is written.
+***************************************************************** */
+#include "params.h"
+#include <signal.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#define PARAMS_LINE 256 ///< longest line of parameter file
+
+/** ****************************************************************
+ * Parameter types
+ *
+ * @brief storage of a parameter in the block
+***************************************************************** */
+enum {
+	PARAM_LONG = 0, ///< long
+	PARAM_INT, ///< int
+	PARAM_HOMEO_PARAM, ///< homeo_param_t
+	PARAM_DOUBLE, ///< double
+	PARAM_FLOAT ///< float
+};
+
+/** ****************************************************************
+ * Parameter key
+ *
+ * @brief name of a parameter in the file and its place in the block
+***************************************************************** */
+typedef struct {
+	const char *name; ///< key in parameter file
+	int type; ///< PARAM_* storage
+	size_t offset; ///< offset in params_t
+} params_key_t;
+
+static const params_key_t params_keys[] = {
+	{"tick_period", PARAM_LONG, offsetof(params_t, tick_period)},
+	{"speed", PARAM_INT, offsetof(params_t, speed)},
+	{"max_dist", PARAM_INT, offsetof(params_t, max_dist)},
+	{"min_dist", PARAM_INT, offsetof(params_t, min_dist)},
+	{"eat_gain", PARAM_HOMEO_PARAM, offsetof(params_t, eat_gain)},
+	{"groom_gain", PARAM_HOMEO_PARAM, offsetof(params_t, groom_gain)},
+	{"damage_scale", PARAM_DOUBLE, offsetof(params_t, damage_scale)},
+	{"speed_damage_mean", PARAM_DOUBLE, offsetof(params_t, speed_damage_mean)},
+	{"speed_damage", PARAM_DOUBLE, offsetof(params_t, speed_damage)},
+	{"circ_ray", PARAM_FLOAT, offsetof(params_t, circ_ray)},
+	{"circ_spread", PARAM_DOUBLE, offsetof(params_t, circ_spread)},
+}; ///< scalar parameters, decay_<need> and cue_<need> are matched with need names
+
+static const params_t params_default = {
+	.tick_period = TIME,
+	.speed = SPEED,
+	.max_dist = MAX_DIST,
+	.min_dist = MIN_DIST,
+	.decay = { [NEED_ENERGY] = HOMEO(DECAY_ENERGY), [NEED_TEGUMENT] = HOMEO(DECAY_TEGUMENT), [NEED_INTEGRITY] = HOMEO(0.0) },
+	.cue = { [NEED_ENERGY] = HOMEO(0.06), [NEED_TEGUMENT] = HOMEO(0.055), [NEED_INTEGRITY] = HOMEO(0.0) },
+	.eat_gain = HOMEO(0.05),
+	.groom_gain = HOMEO(0.05),
+	.damage_scale = 0.01,
+	.speed_damage_mean = 0.05,
+	.speed_damage = SPEED_DAMAGE,
+	.circ_ray = 6,
+	.circ_spread = 0.5,
+	.avoid = {
+		.w = {
+			{0.3, 1.0, 2.0, 2.0, -2.0, -1.0, 0.3, 0.3},
+			{0.3, -1.0, -2.0, -2.0, 2.0, 1.0, 0.3, 0.3},
+		},
+		.bias = {0.5, 0.5},
+	},
+}; ///< historical compile-time values
+
+static params_t params_blocks[2]; ///< published and spare blocks
+static const params_t *params_active = &params_default; ///< published block
+static const char *params_path = NULL; ///< parameter file, NULL if none
+static volatile sig_atomic_t params_reload_requested = 0; ///< set by SIGHUP
+
+/** ****************************************************************
+ * Set a parameter
+ *
+ * @param p parameter block
+ * @param key parameter key
+ * @param value parameter value
+ * @brief function that store a value of the file in the block
+ * @return 0 when ok, -1 if key is unknown
+ * @note avoidance weights are avoid_left_<sensor>, avoid_right_<sensor>, avoid_bias_left and avoid_bias_right
+***************************************************************** */
+static int params_set(params_t *p, const char *key, double value){
+	static const char *wheels[2] = {"left", "right"};
+	char *base = (char*)p, name[32];
+	size_t i;
+	int k, j;
+	for(k=0; k<2; k++){
+		for(j=0; j<8; j++){
+			snprintf(name, sizeof(name), "avoid_%s_%d", wheels[k], j);
+			if(strcmp(key, name) == 0){
+				p->avoid.w[k][j] = value;
+				return 0;
+			}
+		}
+		snprintf(name, sizeof(name), "avoid_bias_%s", wheels[k]);
+		if(strcmp(key, name) == 0){
+			p->avoid.bias[k] = value;
+			return 0;
+		}
+	}
+	for(k=0; k<NEED_COUNT; k++){
+		if(strncmp(key, "decay_", 6) == 0 && strcmp(key+6, need_names[k]) == 0){
+			p->decay[k] = homeo_param(value);
+			return 0;
+		}
+		if(strncmp(key, "cue_", 4) == 0 && strcmp(key+4, need_names[k]) == 0){
+			p->cue[k] = homeo_param(value);
+			return 0;
+		}
+	}
+	for(i=0; i<sizeof(params_keys)/sizeof(params_keys[0]); i++){
+		if(strcmp(key, params_keys[i].name) != 0)
+			continue;
+		switch(params_keys[i].type){
+			case PARAM_LONG: *(long*)(base + params_keys[i].offset) = (long)value; break;
+			case PARAM_INT: *(int*)(base + params_keys[i].offset) = (int)value; break;
+			case PARAM_HOMEO_PARAM: *(homeo_param_t*)(base + params_keys[i].offset) = homeo_param(value); break;
+			case PARAM_DOUBLE: *(double*)(base + params_keys[i].offset) = value; break;
+			case PARAM_FLOAT: *(float*)(base + params_keys[i].offset) = (float)value; break;
+		}
+		return 0;
+	}
+	return -1;
+}
+
+/** ****************************************************************
+ * Load parameter file
+ *
+ * @param path parameter file
+ * @param p parameter block, filled with defaults and values of the file
+ * @brief function that parse "key = value" lines, # starts a comment
+ * @return 0 when ok, -1 if error
+***************************************************************** */
+int params_load(const char *path, params_t *p){
+	char line[PARAMS_LINE], key[64], *c;
+	double value;
+	int n = 0, r = 0;
+	FILE *f = fopen(path, "r");
+	if(f == NULL){
+		printf("ERROR: could not open parameter file %s\n", path);
+		return -1;
+	}
+	*p = params_default;
+	while(fgets(line, sizeof(line), f) != NULL){
+		n++;
+		c = strchr(line, '#');
+		if(c != NULL)
+			*c = '\0';
+		if(sscanf(line, " %63[^= \t\r\n]", key) != 1)
+			continue; // empty line
+		if(sscanf(line, " %63[^= \t\r\n] = %lf", key, &value) != 2){
+			printf("ERROR: %s:%d: expected key = value\n", path, n);
+			r = -1;
+		}
+		else if(params_set(p, key, value) < 0){
+			printf("ERROR: %s:%d: unknown parameter %s\n", path, n, key);
+			r = -1;
+		}
+	}
+	fclose(f);
+	if(r == 0 && (p->tick_period <= 0 || p->max_dist <= p->min_dist)){
+		printf("ERROR: %s: invalid tick_period or min_dist/max_dist\n", path);
+		r = -1;
+	}
+	return r;
+}
+
+/** ****************************************************************
+ * SIGHUP handler
+ *
+ * @param sig signal number
+ * @brief handler that request a reload, reload is done by params_poll()
+***************************************************************** */
+static void params_signal(int sig){
+	params_reload_requested = 1;
+}
+
+/** ****************************************************************
+ * Start parameters
+ *
+ * @param path parameter file
+ * @brief function that load and publish parameter file, then make SIGHUP reload it
+ * @return 0 when ok, -1 if error
+***************************************************************** */
+int params_start(const char *path){
+	struct sigaction sa;
+	if(params_load(path, &params_blocks[0]) < 0)
+		return -1;
+	params_path = path;
+	__atomic_store_n(&params_active, &params_blocks[0], __ATOMIC_RELEASE);
+	sa.sa_handler = params_signal;
+	sigemptyset(&sa.sa_mask);
+	sa.sa_flags = SA_RESTART;
+	return sigaction(SIGHUP, &sa, NULL);
+}
+
+/** ****************************************************************
+ * Get parameters
+ *
+ * @brief function that give the published parameter block
+ * @return parameter block, defaults when no file was loaded
+***************************************************************** */
+const params_t *params_get(void){
+	return __atomic_load_n(&params_active, __ATOMIC_ACQUIRE);
+}
+
+/** ****************************************************************
+ * Poll reload request
+ *
+ * @brief function that reload parameter file if SIGHUP was received
+ * @return 1 if a new block was published, 0 otherwise
+ * @note parameters in use are kept when the file has errors
+***************************************************************** */
+int params_poll(void){
+	params_t *spare;
+	if(!params_reload_requested)
+		return 0;
+	params_reload_requested = 0;
+	spare = params_active == &params_blocks[0] ? &params_blocks[1] : &params_blocks[0];
+	if(params_path == NULL || params_load(params_path, spare) < 0){
+		printf("ERROR: keeping previous parameters\n");
+		return 0;
+	}
+	__atomic_store_n(&params_active, spare, __ATOMIC_RELEASE);
+	printf("Parameters reloaded from %s\n", params_path);
+	return 1;
+}
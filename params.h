@@ -0,0 +1,60 @@
+/** ****************************************************************
+ * @file params.h
+ * @brief Runtime parameters of the model.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * Parameters are read from a "key = value" file into a read-only block,
+ * defaults are the historical compile-time values. The file is read
+ * again on SIGHUP, the new block is published between two ticks so a
+ * tick always sees a single consistent set of parameters.
+***************************************************************** */
+#ifndef PARAMS_H
+#define PARAMS_H
+
+#include "numeric.h"
+#include "needs.h"
+#include "braitenberg.h"
+
+#define SPEED 200  ///< default speed basic input
+#define TIME 100000///< default time for model update (in us)
+#define MAX_DIST 500 ///< default maximum distance for ir sensor
+#define MIN_DIST 80 ///< or 70 | default minimum distance for ir sensor
+
+#define DECAY_ENERGY 0.004 ///< default energy decrease per tick
+#define DECAY_TEGUMENT 0.0015 ///< default tegument decrease per tick
+#define SPEED_DAMAGE 0.5 ///< default sensor speed inducing damage (fraction of max_dist-min_dist per s)
+
+#define PARAMS_FILE "model.conf" ///< default parameter file
+
+/** ****************************************************************
+ * Parameter block
+ *
+ * @brief model parameters, never written once published
+ * @note arrays of NEED_COUNT are in NEED_LIST order, constants compared with
+ * double literals are kept in double so default parameters give the same results
+***************************************************************** */
+typedef struct {
+	long tick_period; ///< period of the model loop (in us)
+	int speed; ///< wheel speed for a motor command equal to 1.0
+	int max_dist; ///< IR value clamped to max_dist
+	int min_dist; ///< IR value below min_dist is 0
+	homeo_param_t decay[NEED_COUNT]; ///< decrease of physiological variables per tick, double in legacy policy
+	homeo_t cue[NEED_COUNT]; ///< constant cues of needs without cue function
+	homeo_param_t eat_gain; ///< energy gained by eat()
+	homeo_param_t groom_gain; ///< tegument gained by groom()
+	double damage_scale; ///< integrity loss for a damage level of 1
+	double speed_damage_mean; ///< mean sensor speed giving speed damage (fraction of max speed)
+	double speed_damage; ///< sensor speed induce damage above it (fraction of max_dist-min_dist per s)
+	float circ_ray; ///< robot ray for circular damage (in cm)
+	double circ_spread; ///< relative difference of neighbour circular speeds spreading damage
+	braitenberg_t avoid; ///< weights of avoidance, for sensors normalized by (max_dist-min_dist)/2, saturated sensors are above 1
+} __attribute__((aligned(64))) params_t;
+
+int params_load(const char *path, params_t *p);
+int params_start(const char *path);
+const params_t *params_get(void);
+int params_poll(void);
+
+#endif
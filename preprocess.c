@@ -0,0 +1,145 @@
+/** ****************************************************************
+ * @file preprocess.c
+ * @brief Fused IR preprocessing kernel of the model tick.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * The 8 IR channels fit in one uint16x8 register, clamped values are
+ * widened to two int32x4 and speeds are two float32x4, so the whole
+ * preprocessing is branch free. Scalar fallback does the same operations
+ * in the same order (reciprocal of dt, pairwise sum of speeds), so both
+ * paths are bit exact.
+***************************************************************** */
+#include "preprocess.h"
+#include <stdlib.h>
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+#define PRE_CIRC_LANES 0x7e ///< lanes of circular damage, sensors 1 to 6
+
+/** ****************************************************************
+ * Normalize a mean
+ *
+ * @param sum sum of 8 values
+ * @param min lower bound
+ * @param max upper bound
+ * @brief function that compute mean of 8 values normalized between min and max
+ * @return normalized mean
+***************************************************************** */
+static float pre_normalize(float sum, float min, float max){
+	float mean = sum / 8;
+	return (mean-min)/(max-min);
+}
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+/** ****************************************************************
+ * Preprocess a frame (NEON)
+ *
+ * @param ir raw IR values of the frame
+ * @param sensors clamped sensors, written
+ * @param prev clamped sensors of previous tick
+ * @param speed sensor speeds, updated
+ * @param dt tick period (in us)
+ * @param p parameters giving IR bounds
+ * @param out kernel results
+ * @brief function that clamp sensors, update speeds and compute means in one pass
+ * @return 0 when ok
+***************************************************************** */
+int preprocess_frame(const uint16_t ir[8], int sensors[8], const int prev[8], float speed[8], float dt, const params_t *p, preprocess_t *out){
+	static const uint32_t bits_lo[4] = {1, 2, 4, 8};
+	static const uint32_t bits_hi[4] = {16, 32, 64, 128};
+	uint16x8_t raw, hi, lo, s;
+	int32x4_t s0, s1, p0, p1, d0, d1, c0, c1, sum;
+	uint32x4_t m0, m1, n0, n1, b0;
+	float32x4_t half = vdupq_n_f32(0.5f), inv = vdupq_n_f32(1.0f/dt), v0, v1;
+	float32x2_t fs;
+	int32x2_t is;
+	uint32x2_t bs;
+
+	// clamp: above max_dist is max_dist, below min_dist is 0, (v-min_dist)/2 otherwise
+	raw = vld1q_u16(ir);
+	hi = vcgtq_u16(raw, vdupq_n_u16(p->max_dist));
+	lo = vcltq_u16(raw, vdupq_n_u16(p->min_dist));
+	s = vshrq_n_u16(vsubq_u16(raw, vdupq_n_u16(p->min_dist)), 1);
+	s = vbslq_u16(hi, vdupq_n_u16(p->max_dist), s);
+	s = vbicq_u16(s, lo);
+	s0 = vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(s)));
+	s1 = vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(s)));
+	vst1q_s32(sensors, s0);
+	vst1q_s32(sensors+4, s1);
+
+	// sensor speed, kept when difference with history is above threshold
+	p0 = vld1q_s32(prev);
+	p1 = vld1q_s32(prev+4);
+	d0 = vsubq_s32(s0, p0);
+	d1 = vsubq_s32(s1, p1);
+	m0 = vcgtq_s32(vabsq_s32(d0), vdupq_n_s32(PRE_SPEED_DIFF(p)));
+	m1 = vcgtq_s32(vabsq_s32(d1), vdupq_n_s32(PRE_SPEED_DIFF(p)));
+	v0 = vmulq_f32(vaddq_f32(vld1q_f32(speed), vmulq_f32(vcvtq_f32_s32(d0), inv)), half);
+	v1 = vmulq_f32(vaddq_f32(vld1q_f32(speed+4), vmulq_f32(vcvtq_f32_s32(d1), inv)), half);
+	v0 = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(v0), m0));
+	v1 = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(v1), m1));
+	vst1q_f32(speed, v0);
+	vst1q_f32(speed+4, v1);
+	b0 = vorrq_u32(vandq_u32(m0, vld1q_u32(bits_lo)), vandq_u32(m1, vld1q_u32(bits_hi)));
+	bs = vorr_u32(vget_low_u32(b0), vget_high_u32(b0));
+	out->delta = vget_lane_u32(bs, 0) | vget_lane_u32(bs, 1);
+
+	// circular damage: 2*|s[i]-prev[i-1]| < s[i]
+	c0 = vsubq_s32(s0, vextq_s32(vdupq_n_s32(0), p0, 3));
+	c1 = vsubq_s32(s1, vextq_s32(p0, p1, 3));
+	n0 = vcltq_s32(vshlq_n_s32(vabsq_s32(c0), 1), s0);
+	n1 = vcltq_s32(vshlq_n_s32(vabsq_s32(c1), 1), s1);
+	n0 = vorrq_u32(vandq_u32(n0, vld1q_u32(bits_lo)), vandq_u32(n1, vld1q_u32(bits_hi)));
+	bs = vorr_u32(vget_low_u32(n0), vget_high_u32(n0));
+	out->circ_near = (vget_lane_u32(bs, 0) | vget_lane_u32(bs, 1)) & PRE_CIRC_LANES;
+
+	// means, sensor sum is exact, speed sum is ((v0+v4)+(v1+v5)) + ((v2+v6)+(v3+v7))
+	sum = vaddq_s32(s0, s1);
+	is = vpadd_s32(vget_low_s32(sum), vget_high_s32(sum));
+	out->ir_mean = pre_normalize((float)(vget_lane_s32(is, 0) + vget_lane_s32(is, 1)), p->min_dist, p->max_dist);
+	v0 = vaddq_f32(v0, v1);
+	fs = vpadd_f32(vget_low_f32(v0), vget_high_f32(v0));
+	out->speed_mean = pre_normalize(vget_lane_f32(fs, 0) + vget_lane_f32(fs, 1), 0.0f, p->max_dist/dt);
+	return 0;
+}
+#else
+/** ****************************************************************
+ * Preprocess a frame (scalar)
+ *
+ * @param ir raw IR values of the frame
+ * @param sensors clamped sensors, written
+ * @param prev clamped sensors of previous tick
+ * @param speed sensor speeds, updated
+ * @param dt tick period (in us)
+ * @param p parameters giving IR bounds
+ * @param out kernel results
+ * @brief function that clamp sensors, update speeds and compute means in one pass
+ * @return 0 when ok
+***************************************************************** */
+int preprocess_frame(const uint16_t ir[8], int sensors[8], const int prev[8], float speed[8], float dt, const params_t *p, preprocess_t *out){
+	float inv = 1.0f/dt, t[4];
+	int i, v, d, sum = 0;
+	unsigned int near = 0, delta = 0;
+	for(i=0; i<8; i++){
+		v = ir[i];
+		v = v > p->max_dist ? p->max_dist : (v < p->min_dist ? 0 : (v-p->min_dist)>>1);
+		sensors[i] = v;
+		sum += v;
+		d = v - prev[i];
+		speed[i] = abs(d) > PRE_SPEED_DIFF(p) ? (speed[i] + (float)d*inv)*0.5f : 0.0f;
+		delta |= (abs(d) > PRE_SPEED_DIFF(p)) << i;
+		d = v - (i > 0 ? prev[i-1] : 0);
+		near |= (2*abs(d) < v) << i;
+	}
+	out->circ_near = near & PRE_CIRC_LANES;
+	out->delta = delta;
+	for(i=0; i<4; i++)
+		t[i] = speed[i] + speed[i+4];
+	out->ir_mean = pre_normalize((float)sum, p->min_dist, p->max_dist);
+	out->speed_mean = pre_normalize((t[0]+t[1]) + (t[2]+t[3]), 0.0f, p->max_dist/dt);
+	return 0;
+}
+#endif
@@ -0,0 +1,34 @@
+/** ****************************************************************
+ * @file preprocess.h
+ * @brief Fused IR preprocessing kernel of the model tick.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * One pass over the 8 IR channels: clamp, differences against history,
+ * damage thresholds and normalized means. NEON on the robot, scalar
+ * fallback elsewhere, both give the same results.
+***************************************************************** */
+#ifndef PREPROCESS_H
+#define PREPROCESS_H
+
+#include <stdint.h>
+#include "params.h"
+
+#define PRE_SPEED_DIFF(p) (((p)->max_dist-(p)->min_dist)/20) ///< sensor difference counted as a speed, 5% of max_dist-min_dist
+
+/** ****************************************************************
+ * Kernel results
+ *
+ * @brief tick values derived from the clamped IR frame
+***************************************************************** */
+typedef struct {
+	float ir_mean; ///< mean of clamped sensors normalized with min_dist/max_dist
+	float speed_mean; ///< mean of sensor speeds normalized with max_dist/dt
+	unsigned int circ_near; ///< bit i set when sensor i is close to history of sensor i-1 (i in 1..6)
+	unsigned int delta; ///< bit i set when sensor i moved by more than 5% of max_dist-min_dist, so its speed is not 0
+} preprocess_t;
+
+int preprocess_frame(const uint16_t ir[8], int sensors[8], const int prev[8], float speed[8], float dt, const params_t *p, preprocess_t *out);
+
+#endif
@@ -0,0 +1,193 @@
+/** ****************************************************************
+ * @file probe.c
+ * @brief Hot-path instrumentation for the model loop.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * Latencies are stored in log-linear histograms (4 sub-buckets per power
+ * of two, so percentiles are known within 25%) updated with atomic
+ * operations, probes can be hit from any thread.
+***************************************************************** */
+#include "probe.h"
+
+#ifdef MODEL_PROBES
+
+#include <signal.h>
+#include <stdio.h>
+
+#define PROBE_SUB_BITS 2 ///< log2 of sub-buckets per power of two
+#define PROBE_BUCKETS (64 << PROBE_SUB_BITS) ///< number of histogram buckets
+
+/** ****************************************************************
+ * Probe histogram
+ *
+ * @brief latency distribution of a stage
+***************************************************************** */
+typedef struct {
+	uint64_t count; ///< number of samples
+	uint64_t sum; ///< sum of samples (in ns)
+	uint64_t min; ///< smallest sample (in ns)
+	uint64_t max; ///< biggest sample (in ns)
+	uint32_t buckets[PROBE_BUCKETS]; ///< log-linear histogram
+} probe_hist_t;
+
+static const char *probe_names[PROBE_COUNT] = {
+	"tick", "get_sensors", "check_if_damage", "update_vars", "compute_speed", "move", "telemetry",
+	"bus ir", "bus us", "bus set_speed", "bus set_mode", "bus leds", "bus battery"
+}; ///< probe names for dump
+
+static probe_hist_t probes[PROBE_COUNT]; ///< histograms of all probes
+static uint32_t probe_last[PROBE_COUNT]; ///< last sample of all probes (in ns, saturated)
+static volatile sig_atomic_t probe_dump_requested = 0; ///< set by SIGUSR1
+
+/** ****************************************************************
+ * Get bucket of a sample
+ *
+ * @param ns sample (in ns)
+ * @brief function that compute log-linear bucket of a sample
+ * @return bucket index
+***************************************************************** */
+static int probe_bucket(uint64_t ns){
+	int msb;
+	if(ns < (1 << PROBE_SUB_BITS))
+		return (int)ns;
+	msb = 63 - __builtin_clzll(ns);
+	return ((msb - PROBE_SUB_BITS + 1) << PROBE_SUB_BITS) + (int)((ns >> (msb - PROBE_SUB_BITS)) & ((1 << PROBE_SUB_BITS) - 1));
+}
+
+/** ****************************************************************
+ * Get bucket upper bound
+ *
+ * @param b bucket index
+ * @brief function that compute biggest sample of a bucket
+ * @return upper bound of bucket (in ns)
+***************************************************************** */
+static uint64_t probe_bucket_max(int b){
+	int msb, sub;
+	if(b < (1 << PROBE_SUB_BITS))
+		return (uint64_t)b;
+	msb = (b >> PROBE_SUB_BITS) + PROBE_SUB_BITS - 1;
+	sub = b & ((1 << PROBE_SUB_BITS) - 1);
+	return ((uint64_t)((1 << PROBE_SUB_BITS) + sub + 1) << (msb - PROBE_SUB_BITS)) - 1;
+}
+
+/** ****************************************************************
+ * Get percentile
+ *
+ * @param h histogram
+ * @param p percentile in [0,1]
+ * @brief function that find percentile upper bound in histogram
+ * @return percentile (in ns), clamped in [min,max]
+***************************************************************** */
+static uint64_t probe_percentile(const probe_hist_t *h, double p){
+	uint64_t target = (uint64_t)(p*h->count), acc = 0, v;
+	int b;
+	for(b=0; b<PROBE_BUCKETS; b++){
+		acc += h->buckets[b];
+		if(acc > target)
+			break;
+	}
+	v = probe_bucket_max(b < PROBE_BUCKETS ? b : PROBE_BUCKETS-1);
+	if(v > h->max)
+		v = h->max;
+	if(v < h->min)
+		v = h->min;
+	return v;
+}
+
+/** ****************************************************************
+ * Record a sample
+ *
+ * @param id probe identifier
+ * @param ns sample (in ns)
+ * @brief function that add a sample to probe histogram, thread safe
+ * @return 0 when ok
+***************************************************************** */
+int probe_record(int id, uint64_t ns){
+	probe_hist_t *h = &probes[id];
+	uint64_t v;
+	__atomic_store_n(&probe_last[id], ns > UINT32_MAX ? UINT32_MAX : (uint32_t)ns, __ATOMIC_RELAXED);
+	if(__atomic_fetch_add(&h->count, 1, __ATOMIC_RELAXED) == 0)
+		__atomic_store_n(&h->min, ns, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&h->sum, ns, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&h->buckets[probe_bucket(ns)], 1, __ATOMIC_RELAXED);
+	v = __atomic_load_n(&h->min, __ATOMIC_RELAXED);
+	while(ns < v && !__atomic_compare_exchange_n(&h->min, &v, ns, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+	v = __atomic_load_n(&h->max, __ATOMIC_RELAXED);
+	while(ns > v && !__atomic_compare_exchange_n(&h->max, &v, ns, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+	return 0;
+}
+
+/** ****************************************************************
+ * Last sample of a probe
+ *
+ * @param id probe identifier
+ * @brief function that give the duration of the last hit of a probe
+ * @return last sample (in ns), 0 if never hit
+***************************************************************** */
+uint32_t probe_last_ns(int id){
+	return __atomic_load_n(&probe_last[id], __ATOMIC_RELAXED);
+}
+
+/** ****************************************************************
+ * Dump probes
+ *
+ * @brief function that print min/p50/p99/max of every probe hit at least once
+ * @return 0 when ok
+***************************************************************** */
+int probe_dump(void){
+	int i;
+	printf("**************************PROBES (us)*************************\n");
+	printf("%-16s %10s %9s %9s %9s %9s %9s\n", "stage", "count", "min", "p50", "p99", "max", "mean");
+	for(i=0; i<PROBE_COUNT; i++){
+		const probe_hist_t *h = &probes[i];
+		if(h->count == 0)
+			continue;
+		printf("%-16s %10llu %9.1f %9.1f %9.1f %9.1f %9.1f\n", probe_names[i], (unsigned long long)h->count,
+			h->min/1000.0, probe_percentile(h, 0.5)/1000.0, probe_percentile(h, 0.99)/1000.0,
+			h->max/1000.0, (double)h->sum/h->count/1000.0);
+	}
+	printf("**************************************************************\n");
+	return 0;
+}
+
+/** ****************************************************************
+ * SIGUSR1 handler
+ *
+ * @param sig signal number
+ * @brief handler that request a probe dump, dump is done by probe_poll()
+***************************************************************** */
+static void probe_signal(int sig){
+	probe_dump_requested = 1;
+}
+
+/** ****************************************************************
+ * Install SIGUSR1 handler
+ *
+ * @brief function that make SIGUSR1 request a probe dump
+ * @return 0 when ok, -1 if error
+***************************************************************** */
+int probe_install_signal(void){
+	struct sigaction sa;
+	sa.sa_handler = probe_signal;
+	sigemptyset(&sa.sa_mask);
+	sa.sa_flags = SA_RESTART;
+	return sigaction(SIGUSR1, &sa, NULL);
+}
+
+/** ****************************************************************
+ * Poll dump request
+ *
+ * @brief function that dump probes if SIGUSR1 was received
+ * @return 1 if probes were dumped, 0 otherwise
+***************************************************************** */
+int probe_poll(void){
+	if(!probe_dump_requested)
+		return 0;
+	probe_dump_requested = 0;
+	probe_dump();
+	return 1;
+}
+
+#endif
@@ -0,0 +1,68 @@
+/** ****************************************************************
+ * @file probe.h
+ * @brief Hot-path instrumentation for the model loop.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * Monotonic clock probes around each stage of the model loop and around
+ * every dsPic bus call, feeding per-stage latency histograms.
+ * Probes are compiled only when MODEL_PROBES is defined (make PROBES=1,
+ * default), otherwise every macro expands to nothing.
+***************************************************************** */
+#ifndef PROBE_H
+#define PROBE_H
+
+#include <stdint.h>
+#include "scheduler.h"
+
+/** ****************************************************************
+ * Probe identifiers
+ *
+ * @brief instrumented stages and bus calls
+***************************************************************** */
+enum {
+	PROBE_TICK = 0, ///< whole tick, without waiting for deadline
+	PROBE_SENSORS, ///< get_sensors()
+	PROBE_DAMAGE, ///< check_if_damage() and apply_damage()
+	PROBE_UPDATE, ///< deficits, cues and motivations
+	PROBE_SPEED, ///< winner_takes_all() and compute_speed()
+	PROBE_MOVE, ///< motor primitive and motor commit
+	PROBE_TELEMETRY, ///< telemetry record
+	PROBE_BUS_IR, ///< kh4_proximity_ir()
+	PROBE_BUS_US, ///< kh4_measure_us()
+	PROBE_BUS_SPEED, ///< kh4_set_speed()
+	PROBE_BUS_MODE, ///< kh4_SetMode()
+	PROBE_BUS_LEDS, ///< kh4_SetRGBLeds()
+	PROBE_BUS_BATTERY, ///< kh4_battery_status() and kh4_battery_charge()
+	PROBE_COUNT ///< number of probes
+};
+
+#ifdef MODEL_PROBES
+
+/// start timing a stage, must be paired with PROBE_END in the same block
+#define PROBE_BEGIN(id) uint64_t probe_t0_##id = monotonic_ns()
+/// stop timing a stage started with PROBE_BEGIN
+#define PROBE_END(id) probe_record(id, monotonic_ns() - probe_t0_##id)
+/// time a single statement, used around bus calls
+#define PROBE_CALL(id, stmt) do{ uint64_t probe_t0 = monotonic_ns(); stmt; probe_record(id, monotonic_ns() - probe_t0); }while(0)
+
+int probe_record(int id, uint64_t ns);
+uint32_t probe_last_ns(int id);
+int probe_dump(void);
+int probe_install_signal(void);
+int probe_poll(void);
+
+#else
+
+#define PROBE_BEGIN(id)
+#define PROBE_END(id)
+#define PROBE_CALL(id, stmt) do{ stmt; }while(0)
+static inline uint32_t probe_last_ns(int id){ return 0; }
+static inline int probe_dump(void){ return 0; }
+static inline int probe_install_signal(void){ return 0; }
+static inline int probe_poll(void){ return 0; }
+
+#endif
+
+#endif
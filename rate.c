@@ -0,0 +1,77 @@
+/** ****************************************************************
+ * @file rate.c
+ * @brief Adaptive control rate of the model loop.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * Slowing down needs RATE_IDLE_TICKS quiet ticks, speeding up a single
+ * active tick, so reaction to an obstacle or damage costs at most one
+ * slow period.
+***************************************************************** */
+#include "rate.h"
+#include <stdio.h>
+
+const int rate_mult[RATE_TIERS] = {1, 2, 4}; ///< period multiplier of each tier
+
+static const char *rate_names[RATE_TIERS] = {"fast", "idle", "save"}; ///< tier names for stats
+
+/** ****************************************************************
+ * Update tier
+ *
+ * @param r rate state
+ * @param active 1 when the last tick saw activity
+ * @param battery battery charge (in %), -1 if unknown
+ * @brief function that select the tier of the next tick
+ * @return 1 when tier changed, 0 otherwise
+***************************************************************** */
+int rate_update(rate_t *r, int active, int battery){
+	int tier = RATE_FAST;
+	if(!r->enabled)
+		return 0;
+	if(active)
+		r->quiet = 0;
+	else if(r->quiet < RATE_IDLE_TICKS)
+		r->quiet++;
+	if(r->quiet >= RATE_IDLE_TICKS)
+		tier = (battery >= 0 && battery < RATE_BATTERY_LOW) ? RATE_SAVE : RATE_IDLE;
+	if(tier == r->tier)
+		return 0;
+	r->tier = tier;
+	r->changes++;
+	return 1;
+}
+
+/** ****************************************************************
+ * Account tick time
+ *
+ * @param r rate state
+ * @param dt_us measured tick period (in us)
+ * @brief function that add a tick period to the time of the actual tier
+ * @return 0 when ok
+***************************************************************** */
+int rate_account(rate_t *r, float dt_us){
+	r->tier_ns[r->tier] += (uint64_t)(dt_us*1000.0f);
+	return 0;
+}
+
+/** ****************************************************************
+ * Print rate stats
+ *
+ * @param r rate state
+ * @brief function that print time spent in each tier
+ * @return 0 when ok
+***************************************************************** */
+int rate_print_stats(const rate_t *r){
+	uint64_t total = 0;
+	int i;
+	if(!r->enabled)
+		return 0;
+	for(i=0; i<RATE_TIERS; i++)
+		total += r->tier_ns[i];
+	printf("Rate: %lu tier changes", r->changes);
+	for(i=0; i<RATE_TIERS; i++)
+		printf(" | %s %.1f s (%.0f%%)", rate_names[i], r->tier_ns[i]/1e9, total ? 100.0*r->tier_ns[i]/total : 0.0);
+	printf("\n");
+	return 0;
+}
@@ -0,0 +1,54 @@
+/** ****************************************************************
+ * @file rate.h
+ * @brief Adaptive control rate of the model loop.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * When the robot is quiet (no sensor moving, nothing near, no damage
+ * detector running) for a while, the loop and sensor polling slow down,
+ * more when the battery is low. Any activity brings the fast rate back on
+ * the next tick. Decays are scaled with the period, so physiological
+ * variables decrease at the same pace in time whatever the rate.
+***************************************************************** */
+#ifndef RATE_H
+#define RATE_H
+
+#include <stdint.h>
+
+#define RATE_IDLE_TICKS 20 ///< quiet ticks before the loop slows down
+#define RATE_NEAR 0.1f ///< normalized IR mean above which an obstacle is near and the loop stays fast
+#define RATE_BATTERY_LOW 20 ///< battery charge below which a quiet loop enters power saving (in %)
+
+/** ****************************************************************
+ * Rate tiers
+ *
+ * @brief loop rates, by decreasing rate
+***************************************************************** */
+enum {
+	RATE_FAST = 0, ///< nominal tick and acquisition periods
+	RATE_IDLE, ///< quiet robot, periods multiplied by 2
+	RATE_SAVE, ///< quiet robot with low battery, periods multiplied by 4 and leds off
+	RATE_TIERS ///< number of tiers
+};
+
+extern const int rate_mult[RATE_TIERS];
+
+/** ****************************************************************
+ * Rate state
+ *
+ * @brief tier of the loop and time spent in each tier
+***************************************************************** */
+typedef struct {
+	int enabled; ///< 1 when the rate adapts, the loop stays in RATE_FAST otherwise
+	int tier; ///< actual tier
+	int quiet; ///< consecutive quiet ticks
+	unsigned long changes; ///< tier changes
+	uint64_t tier_ns[RATE_TIERS]; ///< time spent in each tier (in ns)
+} rate_t;
+
+int rate_update(rate_t *r, int active, int battery);
+int rate_account(rate_t *r, float dt_us);
+int rate_print_stats(const rate_t *r);
+
+#endif
@@ -0,0 +1,246 @@
+/** ****************************************************************
+ * @file replay.c
+ * @brief Offline replay of the decision model on telemetry files.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * The telemetry file is memory mapped by windows of REPLAY_WINDOW bytes,
+ * so logs bigger than the address space of the robot stream through the
+ * page cache without being loaded. Each run of the file (tick going back)
+ * starts a new model context, options are the model options of -m.
+***************************************************************** */
+#define _FILE_OFFSET_BITS 64
+#include "replay.h"
+#include "model.h"
+#include "telemetry.h"
+#include "probe.h"
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/** ****************************************************************
+ * Mapped file
+ *
+ * @brief window of a telemetry file mapped in memory
+***************************************************************** */
+typedef struct {
+	int fd; ///< telemetry file
+	off_t size; ///< file size (in bytes)
+	long page; ///< page size (in bytes)
+	char *map; ///< mapped window, NULL if none
+	off_t map_off; ///< file offset of mapped window
+	size_t map_len; ///< size of mapped window (in bytes)
+} replay_file_t;
+
+/** ****************************************************************
+ * Replay results
+ *
+ * @brief comparison of replayed and recorded decisions
+***************************************************************** */
+typedef struct {
+	unsigned long runs; ///< runs replayed
+	unsigned long ticks; ///< ticks replayed
+	unsigned long diffs; ///< ticks with a different decision
+	unsigned long gaps; ///< records missing in file (dropped by telemetry)
+	float max_var_diff; ///< biggest difference of a physiological variable
+} replay_stats_t;
+
+/** ****************************************************************
+ * Get a record
+ *
+ * @param f mapped file
+ * @param off file offset of record
+ * @param size size of record (in bytes)
+ * @brief function that give a record of the file, the window is moved when needed
+ * @return record, NULL at end of file or if error
+***************************************************************** */
+static const void *replay_get(replay_file_t *f, off_t off, size_t size){
+	off_t start;
+	if(off + (off_t)size > f->size)
+		return NULL;
+	if(f->map == NULL || off < f->map_off || off + (off_t)size > f->map_off + (off_t)f->map_len){
+		if(f->map != NULL)
+			munmap(f->map, f->map_len);
+		start = off & ~(off_t)(f->page-1);
+		f->map_len = REPLAY_WINDOW;
+		if(start + (off_t)f->map_len > f->size)
+			f->map_len = f->size - start;
+		f->map = mmap(NULL, f->map_len, PROT_READ, MAP_PRIVATE, f->fd, start);
+		if(f->map == MAP_FAILED){
+			printf("ERROR: could not map telemetry file\n");
+			f->map = NULL;
+			return NULL;
+		}
+		f->map_off = start;
+		madvise(f->map, f->map_len, MADV_SEQUENTIAL);
+	}
+	return f->map + (off - f->map_off);
+}
+
+/** ****************************************************************
+ * Feed a recorded frame
+ *
+ * @param m model context
+ * @param r recorded tick
+ * @brief function that publish raw frame of a record and set the tick timing
+ * @return 0 when ok
+***************************************************************** */
+static int replay_frame(model_t *m, const telemetry_record_t *r){
+	ir_frame_t frame;
+	int i;
+	memset(&frame, 0, sizeof(frame));
+	frame.t_ns = r->t_ns;
+	frame.seq = r->tick;
+	frame.us_t_ns = r->us_t_ns;
+	for(i=0; i<IR_CHANNELS; i++)
+		frame.ir[i] = r->ir[i];
+	for(i=0; i<GROUND_CHANNELS; i++)
+		frame.ground[i] = r->ground[i];
+	for(i=0; i<HAL_US_CHANNELS; i++)
+		frame.us[i] = r->us[i];
+	frame.battery = r->battery;
+	frame.current = r->current;
+	acquisition_inject(&m->acquisition, &frame);
+	m->tick_dt = r->dt; // period measured by the recorded loop
+	m->sched.last_ns = r->t_ns; // clock of motor primitives
+	return 0;
+}
+
+/** ****************************************************************
+ * Compare a tick
+ *
+ * @param m model context, after the replayed tick
+ * @param r recorded tick
+ * @param behaviour replayed decision
+ * @param s replay results, updated
+ * @param diff CSV file of differing ticks, NULL if none
+ * @brief function that compare replayed decision and variables with the record
+ * @return 1 when decisions differ, 0 otherwise
+***************************************************************** */
+static int replay_compare(model_t *m, const telemetry_record_t *r, int behaviour, replay_stats_t *s, FILE *diff){
+	float d;
+	int k;
+	for(k=0; k<NEED_COUNT; k++){
+		d = fabsf(homeo_to_float(m->var[k]) - r->var[k]);
+		if(d > s->max_var_diff)
+			s->max_var_diff = d;
+	}
+	s->ticks++;
+	if(behaviour == r->behaviour)
+		return 0;
+	if(s->diffs < REPLAY_DIFFS)
+		printf("Replay: run %lu tick %u recorded %s replayed %s\n", s->runs, r->tick,
+			(r->behaviour >= 0 && r->behaviour < NEED_COUNT) ? need_names[r->behaviour] : "none", need_names[behaviour]);
+	if(diff != NULL)
+		fprintf(diff, "%lu,%u,%d,%d\n", s->runs, r->tick, r->behaviour, behaviour);
+	s->diffs++;
+	return 1;
+}
+
+/** ****************************************************************
+ * Replay entry point
+ *
+ * @param argc number of program arguments
+ * @param argv program arguments, -p telemetry.bin [-o diff.csv] [model options]
+ * @brief function that replay a telemetry file and print the decision diff
+ * @return 0 when all decisions are the same, 1 if some differ, -1 if error
+ * @note every run of the file is replayed with the model options of the command line
+***************************************************************** */
+int replay_main(int argc, char *argv[]){
+	replay_file_t f;
+	replay_stats_t s;
+	telemetry_header_t header;
+	const telemetry_record_t *r;
+	model_t *m = NULL;
+	FILE *diff = NULL;
+	struct stat st;
+	off_t off;
+	uint64_t t0;
+	double elapsed;
+	int i, opt_argc = 0, started = 0;
+	char **opt_argv;
+
+	if(argc < 3){
+		printf("usage: %s -p telemetry.bin [-o diff.csv] [model options]\n", argv[0]);
+		return -1;
+	}
+	opt_argv = calloc(argc, sizeof(char*));
+	for(i=3; i<argc; i++){
+		if(strcmp(argv[i],"-o")==0 && i+1<argc)
+			diff = fopen(argv[++i], "w");
+		else
+			opt_argv[opt_argc++] = argv[i];
+	}
+	memset(&f, 0, sizeof(f));
+	memset(&s, 0, sizeof(s));
+	f.page = sysconf(_SC_PAGESIZE);
+	f.fd = open(argv[2], O_RDONLY);
+	if(f.fd < 0 || fstat(f.fd, &st) < 0 || pread(f.fd, &header, sizeof(header), 0) != sizeof(header)
+		|| header.magic != TELEMETRY_MAGIC){
+		printf("ERROR: %s is not a telemetry file\n", argv[2]);
+		return -1;
+	}
+	if(header.version != TELEMETRY_VERSION || header.record_size != sizeof(telemetry_record_t)){
+		printf("ERROR: unsupported telemetry version %d (record size %d)\n", header.version, header.record_size);
+		return -1;
+	}
+	if(diff != NULL)
+		fprintf(diff, "run,tick,recorded,replayed\n");
+	f.size = st.st_size;
+	// model context is big and history is cache line aligned
+	if(posix_memalign((void**)&m, HISTORY_ALIGN, sizeof(model_t)) != 0){
+		printf("ERROR: could not allocate model context\n");
+		return -1;
+	}
+
+	t0 = monotonic_ns();
+	for(off=sizeof(header); (r = replay_get(&f, off, sizeof(*r))) != NULL; off += sizeof(*r)){
+		if(r->tick == 0 || (started && r->tick <= m->tick)){
+			// new run (tick goes back, its first records may be dropped), same start as model_run() without robot
+			model_init(m, NULL);
+			if(model_options(m, opt_argc, opt_argv) < 0 || stats_init(&m->ir_stats, m->cue_alpha) < 0)
+				break;
+			s.runs++;
+			replay_frame(m, r);
+			model_prime(m);
+			if(r->tick > 0){
+				// run joined late, physiological state is taken from the record
+				for(i=0; i<NEED_COUNT; i++)
+					m->var[i] = homeo_from_float(r->var[i]);
+				m->var_dirty = NEED_ALL;
+				m->tick = r->tick;
+				s.gaps += r->tick;
+			}
+			started = 1;
+			continue;
+		}
+		if(!started)
+			continue; // run started before the file
+		if(r->tick > m->tick+1){
+			s.gaps += r->tick - (m->tick+1);
+			m->tick = r->tick-1;
+		}
+		replay_frame(m, r);
+		replay_compare(m, r, model_tick(m), &s, diff);
+		model_adapt(m); // same rate tiers as the recorded loop with -e
+	}
+	elapsed = (monotonic_ns() - t0)/1e9;
+
+	printf("Replay: %lu runs | %lu ticks in %.3f s (%.0f ticks/s) | %lu decisions differ | %lu missing records | max variable difference %g\n",
+		s.runs, s.ticks, elapsed, s.ticks/(elapsed > 0 ? elapsed : 1), s.diffs, s.gaps, s.max_var_diff);
+	probe_dump();
+	if(f.map != NULL)
+		munmap(f.map, f.map_len);
+	close(f.fd);
+	if(diff != NULL)
+		fclose(diff);
+	free(m);
+	free(opt_argv);
+	return s.diffs > 0;
+}
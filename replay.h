@@ -0,0 +1,20 @@
+/** ****************************************************************
+ * @file replay.h
+ * @brief Offline replay of the decision model on telemetry files.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * Raw frames recorded in a telemetry file are fed back to the model tick
+ * as fast as the CPU allows, with motors stubbed out, and the replayed
+ * decisions are compared with the recorded ones.
+***************************************************************** */
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#define REPLAY_WINDOW (64L << 20) ///< size of the file window mapped at once (in bytes)
+#define REPLAY_DIFFS 20 ///< number of differing ticks printed
+
+int replay_main(int argc, char *argv[]);
+
+#endif
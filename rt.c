@@ -0,0 +1,159 @@
+/** ****************************************************************
+ * @file rt.c
+ * @brief Opt-in real-time setup of the model process.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * Buffers of the model are static or allocated before the loop starts,
+ * so once memory is locked the loop runs without page faults. Page faults
+ * are counted from the loop start to check it.
+***************************************************************** */
+#define _GNU_SOURCE
+#include "rt.h"
+#include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+/** ****************************************************************
+ * Real-time state
+ *
+ * @brief setup done by rt_start(), read by threads started later
+***************************************************************** */
+static struct {
+	int enabled; ///< 1 once real-time mode is set up
+	int cpu; ///< CPU of the control thread, -1 when the board has a single CPU
+	long minflt; ///< minor page faults at loop start
+	long majflt; ///< major page faults at loop start
+} rt = {0, -1, 0, 0};
+
+/** ****************************************************************
+ * Pre-fault stack
+ *
+ * @brief function that touch RT_STACK bytes of stack, so the loop does not fault on it
+ * @return 0 when ok
+ * @note one byte per page is written through the volatile array, so the writes are not removed,
+ * not inlined so the array is below the frame of the caller
+***************************************************************** */
+static __attribute__((noinline)) int rt_prefault_stack(void){
+	volatile char stack[RT_STACK];
+	long page = sysconf(_SC_PAGESIZE), i;
+	if(page <= 0)
+		page = 4096;
+	for(i=0; i<RT_STACK; i+=page)
+		stack[i] = 0;
+	stack[RT_STACK-1] = 0;
+	return stack[0]; // 0, read back so the array is used
+}
+
+/** ****************************************************************
+ * Set class of a thread
+ *
+ * @param thread thread to set
+ * @param cls thread class (RT_CONTROL, RT_ACQUISITION or RT_BACKGROUND)
+ * @brief function that set scheduling class and CPU of a thread
+ * @return 0 when ok, -1 if error
+ * @note does nothing outside real-time mode, used for threads started before rt_start()
+***************************************************************** */
+int rt_set(pthread_t thread, int cls){
+	struct sched_param sp;
+	cpu_set_t cpus;
+	int policy = SCHED_FIFO, i, n;
+	if(!__atomic_load_n(&rt.enabled, __ATOMIC_ACQUIRE))
+		return 0;
+	memset(&sp, 0, sizeof(sp));
+	sp.sched_priority = cls == RT_CONTROL ? RT_PRIORITY : RT_PRIORITY-1;
+	if(cls == RT_BACKGROUND){
+		policy = SCHED_OTHER; // threads inherit SCHED_FIFO from the control thread
+		sp.sched_priority = 0;
+	}
+	if(pthread_setschedparam(thread, policy, &sp) != 0){
+		printf("ERROR: could not set scheduling class %d\n", cls);
+		return -1;
+	}
+	if(rt.cpu < 0)
+		return 0;
+	CPU_ZERO(&cpus);
+	n = sysconf(_SC_NPROCESSORS_ONLN);
+	for(i=0; i<n; i++)
+		if(cls == RT_ACQUISITION || (cls == RT_BACKGROUND) != (i == rt.cpu))
+			CPU_SET(i, &cpus); // acquisition feeds the control thread, it may run anywhere
+	if(pthread_setaffinity_np(thread, sizeof(cpus), &cpus) != 0){
+		printf("ERROR: could not pin thread class %d\n", cls);
+		return -1;
+	}
+	return 0;
+}
+
+/** ****************************************************************
+ * Set thread class
+ *
+ * @param cls thread class (RT_CONTROL, RT_ACQUISITION or RT_BACKGROUND)
+ * @brief function that set scheduling class and CPU of the calling thread
+ * @return 0 when ok, -1 if error
+ * @note does nothing outside real-time mode, threads call it when they start
+***************************************************************** */
+int rt_thread(int cls){
+	return rt_set(pthread_self(), cls);
+}
+
+/** ****************************************************************
+ * Start real-time mode
+ *
+ * @brief function that lock memory and make the calling thread the control thread
+ * @return 0 when ok, -1 if error
+ * @note call it from the control thread before starting telemetry, acquisition and agent threads
+ * @note needs root or CAP_SYS_NICE and CAP_IPC_LOCK
+***************************************************************** */
+int rt_start(void){
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	mallopt(M_TRIM_THRESHOLD, -1); // freed memory stays mapped
+	mallopt(M_MMAP_MAX, 0); // big allocations come from the locked heap
+	if(mlockall(MCL_CURRENT | MCL_FUTURE) < 0){
+		printf("ERROR: could not lock memory\n");
+		return -1;
+	}
+	rt_prefault_stack();
+	rt.cpu = n > 1 ? (int)n-1 : -1;
+	__atomic_store_n(&rt.enabled, 1, __ATOMIC_RELEASE);
+	return rt_thread(RT_CONTROL);
+}
+
+/** ****************************************************************
+ * Mark loop start
+ *
+ * @brief function that start counting page faults, once every thread and buffer is set up
+ * @return 0 when ok
+ * @note does nothing outside real-time mode
+***************************************************************** */
+int rt_loop_start(void){
+	struct rusage ru;
+	if(!rt.enabled)
+		return 0;
+	getrusage(RUSAGE_SELF, &ru);
+	rt.minflt = ru.ru_minflt;
+	rt.majflt = ru.ru_majflt;
+	return 0;
+}
+
+/** ****************************************************************
+ * Print real-time stats
+ *
+ * @brief function that print page faults of the process since the loop start
+ * @return 0 when ok
+ * @note deadline misses are printed by the scheduler stats
+***************************************************************** */
+int rt_print_stats(void){
+	struct rusage ru;
+	if(!rt.enabled)
+		return 0;
+	getrusage(RUSAGE_SELF, &ru);
+	printf("Real-time: SCHED_FIFO %d | control CPU %d | memory locked | %ld minor, %ld major page faults in loop\n",
+		RT_PRIORITY, rt.cpu, ru.ru_minflt - rt.minflt, ru.ru_majflt - rt.majflt);
+	return 0;
+}
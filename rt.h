@@ -0,0 +1,38 @@
+/** ****************************************************************
+ * @file rt.h
+ * @brief Opt-in real-time setup of the model process.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * In real-time mode (model -m --rt) memory is locked and pre-faulted,
+ * the control thread runs SCHED_FIFO, acquisition and bus owner just below it, and
+ * telemetry, LED and network threads stay in the normal class, away
+ * from the control CPU when the board has more than one.
+***************************************************************** */
+#ifndef RT_H
+#define RT_H
+
+#include <pthread.h>
+
+#define RT_PRIORITY 80 ///< SCHED_FIFO priority of the control thread
+#define RT_STACK (256*1024) ///< stack pre-faulted for the control thread (in bytes)
+
+/** ****************************************************************
+ * Thread classes
+ *
+ * @brief scheduling class of a thread in real-time mode
+***************************************************************** */
+enum {
+	RT_CONTROL = 0, ///< model loop, SCHED_FIFO at RT_PRIORITY
+	RT_ACQUISITION, ///< sensor acquisition and bus owner, SCHED_FIFO just below the control thread
+	RT_BACKGROUND ///< telemetry, LED and network threads, normal class
+};
+
+int rt_start(void);
+int rt_set(pthread_t thread, int cls);
+int rt_thread(int cls);
+int rt_loop_start(void);
+int rt_print_stats(void);
+
+#endif
@@ -0,0 +1,486 @@
+/** ****************************************************************
+ * @file runner.c
+ * @brief Batch experiment runner on the simulated robot.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * Episodes are dealt to per-worker deques up front, workers pop their
+ * own episodes and steal from the others when idle, so long episodes
+ * (robots that survive) do not leave threads waiting at the end.
+***************************************************************** */
+#include "runner.h"
+#include "model.h"
+#include "hal_sim.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+
+/** ****************************************************************
+ * Worker state
+ *
+ * @brief one thread of the pool and its deque
+***************************************************************** */
+typedef struct runner_worker {
+	int id; ///< worker index
+	pthread_t thread; ///< worker thread
+	runner_deque_t deque; ///< episodes owned by the worker
+	struct runner_pool *pool; ///< pool of the worker
+	unsigned long done; ///< episodes run by the worker
+	unsigned long steals; ///< episodes stolen from other workers
+} runner_worker_t;
+
+/** ****************************************************************
+ * Pool state
+ *
+ * @brief workers and episodes of a batch
+***************************************************************** */
+typedef struct runner_pool {
+	int n_workers; ///< number of workers
+	runner_worker_t *workers; ///< workers
+	int n_episodes; ///< number of episodes
+	episode_t *episodes; ///< episode parameters and results
+	uint32_t max_ticks; ///< episode length limit (in ticks)
+	int fusion; ///< 1 when episodes fuse ground sensors and ultrasounds
+	int rate; ///< 1 when episodes adapt their loop rate
+} runner_pool_t;
+
+/** ****************************************************************
+ * Push episode
+ *
+ * @param d deque
+ * @param x episode index
+ * @brief function that push an episode at the bottom of a deque (owner side)
+ * @return 0 when ok, -1 if deque is full
+***************************************************************** */
+static int deque_push(runner_deque_t *d, int x){
+	long b = __atomic_load_n(&d->bottom, __ATOMIC_RELAXED);
+	long t = __atomic_load_n(&d->top, __ATOMIC_ACQUIRE);
+	if(b - t >= RUNNER_DEQUE_SIZE)
+		return -1;
+	d->buf[b % RUNNER_DEQUE_SIZE] = x;
+	__atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELEASE);
+	return 0;
+}
+
+/** ****************************************************************
+ * Pop episode
+ *
+ * @param d deque
+ * @brief function that pop an episode at the bottom of a deque (owner side)
+ * @return episode index, -1 if deque is empty
+***************************************************************** */
+static int deque_pop(runner_deque_t *d){
+	long b = __atomic_load_n(&d->bottom, __ATOMIC_RELAXED) - 1;
+	long t;
+	int x = -1;
+	__atomic_store_n(&d->bottom, b, __ATOMIC_SEQ_CST);
+	t = __atomic_load_n(&d->top, __ATOMIC_SEQ_CST);
+	if(t <= b){
+		x = d->buf[b % RUNNER_DEQUE_SIZE];
+		if(t == b){
+			// last episode, race with thieves
+			if(!__atomic_compare_exchange_n(&d->top, &t, t + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+				x = -1;
+			__atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELAXED);
+		}
+	}
+	else
+		__atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELAXED);
+	return x;
+}
+
+/** ****************************************************************
+ * Steal episode
+ *
+ * @param d deque
+ * @brief function that steal an episode at the top of a deque (thief side)
+ * @return episode index, -1 if deque is empty or steal was lost
+***************************************************************** */
+static int deque_steal(runner_deque_t *d){
+	long t = __atomic_load_n(&d->top, __ATOMIC_SEQ_CST);
+	long b = __atomic_load_n(&d->bottom, __ATOMIC_SEQ_CST);
+	int x;
+	if(t >= b)
+		return -1;
+	x = d->buf[t % RUNNER_DEQUE_SIZE];
+	if(!__atomic_compare_exchange_n(&d->top, &t, t + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+		return -1;
+	return x;
+}
+
+/** ****************************************************************
+ * Remaining episodes
+ *
+ * @param d deque
+ * @brief function that give the number of episodes left in a deque
+ * @return number of episodes, may be stale
+***************************************************************** */
+static long deque_size(runner_deque_t *d){
+	long t = __atomic_load_n(&d->top, __ATOMIC_ACQUIRE);
+	long b = __atomic_load_n(&d->bottom, __ATOMIC_ACQUIRE);
+	return b > t ? b - t : 0;
+}
+
+/** ****************************************************************
+ * Run one episode
+ *
+ * @param pool pool of the batch
+ * @param e episode parameters and results
+ * @brief function that run a model episode on its own simulated robot
+ * @return 0 when ok, -1 if error
+***************************************************************** */
+static int run_episode(runner_pool_t *pool, episode_t *e){
+	model_t *m;
+	hal_dev_t *dev;
+	int r, k;
+	if(posix_memalign((void **)&m, HISTORY_ALIGN, sizeof(model_t)) != 0)
+		m = NULL; // history frames are cache line aligned
+	dev = hal_sim_open(e->seed);
+	if(m == NULL || dev == NULL){
+		printf("ERROR: could not allocate episode %u\n", e->seed);
+		free(m);
+		if(dev)
+			hal_sim_destroy(dev);
+		return -1;
+	}
+	model_init(m, dev);
+	for(k=0; k<NEED_COUNT; k++)
+		m->decay[k] = homeo_from_float(e->decay[k]);
+	if(pool->fusion){
+		m->fusion = 1;
+		hal_activate_us(dev, HAL_US_ALL);
+	}
+	m->rate.enabled = pool->rate;
+	r = model_run(m, pool->max_ticks);
+	motors_stop(&m->motors);
+	e->ticks = m->tick;
+	e->switches = m->switches;
+	memcpy(e->behaviour_ticks, m->behaviour_ticks, sizeof(e->behaviour_ticks));
+	e->cause = model_death_cause(m) + 1;
+	e->collisions = hal_sim_collisions(dev);
+	e->decisions = m->decisions;
+	for(k=0; k<NEED_COUNT; k++)
+		e->var[k] = homeo_to_float(m->var[k]);
+	memcpy(e->tier_ns, m->rate.tier_ns, sizeof(e->tier_ns));
+	hal_sim_destroy(dev);
+	free(m);
+	return r < 0 ? -1 : 0;
+}
+
+/** ****************************************************************
+ * Worker thread
+ *
+ * @param arg worker state
+ * @brief thread that run own episodes, then steal from the busiest worker
+ * @return NULL
+***************************************************************** */
+static void *runner_thread(void *arg){
+	runner_worker_t *w = arg;
+	runner_pool_t *pool = w->pool;
+	int x, i, victim;
+	long size, best;
+	for(;;){
+		x = deque_pop(&w->deque);
+		if(x < 0){
+			// steal from the worker with most episodes left
+			victim = -1;
+			best = 0;
+			for(i=0; i<pool->n_workers; i++){
+				if(i == w->id)
+					continue;
+				size = deque_size(&pool->workers[i].deque);
+				if(size > best){
+					best = size;
+					victim = i;
+				}
+			}
+			if(victim < 0)
+				break; // no episode left anywhere, deques are never refilled
+			x = deque_steal(&pool->workers[victim].deque);
+			if(x < 0)
+				continue; // lost the race, look again
+			w->steals++;
+		}
+		run_episode(pool, &pool->episodes[x]);
+		w->done++;
+	}
+	return NULL;
+}
+
+/** ****************************************************************
+ * Print batch summary
+ *
+ * @param pool pool of the batch
+ * @param wall_s wall clock time of the batch (in s)
+ * @brief function that print survival, switches, behaviour share and causes of death
+ * @return 0 when ok
+***************************************************************** */
+static int runner_print(const runner_pool_t *pool, double wall_s){
+	unsigned long causes[NEED_COUNT+1];
+	double bticks[NEED_COUNT];
+	double ticks = 0, switches = 0, tier_s[RATE_TIERS] = {0}, time_s = 0;
+	uint32_t min_ticks = 0xffffffff, max_ticks = 0;
+	unsigned long steals = 0;
+	int i, k;
+	memset(causes, 0, sizeof(causes));
+	memset(bticks, 0, sizeof(bticks));
+	for(i=0; i<pool->n_episodes; i++){
+		const episode_t *e = &pool->episodes[i];
+		ticks += e->ticks;
+		switches += e->switches;
+		if(e->ticks < min_ticks) min_ticks = e->ticks;
+		if(e->ticks > max_ticks) max_ticks = e->ticks;
+		causes[e->cause]++;
+		for(k=0; k<NEED_COUNT; k++)
+			bticks[k] += e->behaviour_ticks[k];
+		for(k=0; k<RATE_TIERS; k++){
+			tier_s[k] += e->tier_ns[k]/1e9;
+			time_s += e->tier_ns[k]/1e9;
+		}
+	}
+	for(i=0; i<pool->n_workers; i++)
+		steals += pool->workers[i].steals;
+	printf("Batch: %d episodes on %d threads in %.2f s | %lu steals\n", pool->n_episodes, pool->n_workers, wall_s, steals);
+	printf("Survival: mean %.1f ticks (%.1f s) | min %u | max %u\n",
+		ticks/pool->n_episodes, ticks/pool->n_episodes*params_get()->tick_period/1e6, min_ticks, max_ticks);
+	if(pool->rate)
+		printf("Rate: mean %.1f s per episode | fast %.1f%% | idle %.1f%% | save %.1f%% of time\n", time_s/pool->n_episodes,
+			100.0*tier_s[RATE_FAST]/time_s, 100.0*tier_s[RATE_IDLE]/time_s, 100.0*tier_s[RATE_SAVE]/time_s);
+	printf("Switches: mean %.1f per episode\n", switches/pool->n_episodes);
+	printf("Behaviour share:");
+	for(k=0; k<NEED_COUNT; k++)
+		printf("%s %s %.1f%%", k ? " |" : "", need_names[k], 100.0*bticks[k]/ticks);
+	printf("\nCause of death:");
+	for(k=0; k<NEED_COUNT; k++)
+		printf(" %s %lu |", need_names[k], causes[k+1]);
+	printf(" alive at %u ticks %lu\n", pool->max_ticks, causes[0]);
+	return 0;
+}
+
+/** ****************************************************************
+ * Write batch results
+ *
+ * @param pool pool of the batch
+ * @param path CSV file
+ * @brief function that write one CSV line per episode
+ * @return 0 when ok, -1 if error
+***************************************************************** */
+static int runner_write_csv(const runner_pool_t *pool, const char *path){
+	int i, k;
+	FILE *f = fopen(path, "w");
+	if(f == NULL){
+		printf("ERROR: could not open %s\n", path);
+		return -1;
+	}
+	fprintf(f, "episode,seed");
+	for(k=0; k<NEED_COUNT; k++)
+		fprintf(f, ",decay_%s", need_names[k]);
+	fprintf(f, ",ticks,switches");
+	for(k=0; k<NEED_COUNT; k++)
+		fprintf(f, ",ticks_%s", need_names[k]);
+	fprintf(f, ",cause,collisions,decisions");
+	for(k=0; k<NEED_COUNT; k++)
+		fprintf(f, ",var_%s", need_names[k]);
+	fprintf(f, "\n");
+	for(i=0; i<pool->n_episodes; i++){
+		const episode_t *e = &pool->episodes[i];
+		fprintf(f, "%d,%u", i, e->seed);
+		for(k=0; k<NEED_COUNT; k++)
+			fprintf(f, ",%.6f", e->decay[k]);
+		fprintf(f, ",%u,%lu", e->ticks, e->switches);
+		for(k=0; k<NEED_COUNT; k++)
+			fprintf(f, ",%lu", e->behaviour_ticks[k]);
+		fprintf(f, ",%d,%lu,%08x", e->cause, e->collisions, e->decisions);
+		for(k=0; k<NEED_COUNT; k++)
+			fprintf(f, ",%.9g", e->var[k]);
+		fprintf(f, "\n");
+	}
+	fclose(f);
+	return 0;
+}
+
+/** ****************************************************************
+ * Compare with reference results
+ *
+ * @param pool pool of the batch
+ * @param path CSV file written by a reference build (same episodes, seed and max ticks)
+ * @brief function that check that every episode took the same decisions as the reference
+ * @return 0 when all decisions are the same, -1 otherwise or if error
+ * @note physiological variables are compared too, fixed point policy is never
+ * bit exact, float policy may be (no double rounding on the host)
+***************************************************************** */
+static int runner_compare(const runner_pool_t *pool, const char *path){
+	char line[1024], *tok, *save;
+	int col_decisions = -1, col_var[NEED_COUNT];
+	int i, k, col, n = 0, same = 0, exact = 0, first = -1, found;
+	unsigned int decisions;
+	float var[NEED_COUNT], diff, max_diff = 0;
+	FILE *f = fopen(path, "r");
+	if(f == NULL){
+		printf("ERROR: could not open %s\n", path);
+		return -1;
+	}
+	if(fgets(line, sizeof(line), f) == NULL){
+		printf("ERROR: empty reference %s\n", path);
+		fclose(f);
+		return -1;
+	}
+	// columns are found by name, so a reference may have other needs or columns
+	for(k=0; k<NEED_COUNT; k++)
+		col_var[k] = -1;
+	line[strcspn(line, "\r\n")] = 0;
+	for(col=0, tok=strtok_r(line, ",", &save); tok != NULL; col++, tok=strtok_r(NULL, ",", &save)){
+		if(strcmp(tok, "decisions") == 0)
+			col_decisions = col;
+		for(k=0; k<NEED_COUNT; k++)
+			if(strncmp(tok, "var_", 4) == 0 && strcmp(tok+4, need_names[k]) == 0)
+				col_var[k] = col;
+	}
+	for(k=0; k<NEED_COUNT; k++)
+		if(col_var[k] < 0)
+			col_decisions = -1;
+	if(col_decisions < 0){
+		printf("ERROR: reference %s has no decisions or variables of all needs\n", path);
+		fclose(f);
+		return -1;
+	}
+	while(n < pool->n_episodes && fgets(line, sizeof(line), f) != NULL){
+		const episode_t *e = &pool->episodes[n];
+		found = 0;
+		i = -1;
+		for(col=0, tok=strtok_r(line, ",", &save); tok != NULL; col++, tok=strtok_r(NULL, ",", &save)){
+			if(col == 0)
+				i = atoi(tok);
+			if(col == col_decisions && sscanf(tok, "%x", &decisions) == 1)
+				found++;
+			for(k=0; k<NEED_COUNT; k++)
+				if(col == col_var[k] && sscanf(tok, "%f", &var[k]) == 1)
+					found++;
+		}
+		if(found != NEED_COUNT+1 || i != n){
+			printf("ERROR: reference %s line %d is not a compatible episode\n", path, n+2);
+			fclose(f);
+			return -1;
+		}
+		if(decisions == e->decisions)
+			same++;
+		else if(first < 0)
+			first = n;
+		if(memcmp(var, e->var, sizeof(var)) == 0)
+			exact++;
+		for(k=0; k<NEED_COUNT; k++){
+			diff = fabsf(var[k] - e->var[k]);
+			if(diff > max_diff)
+				max_diff = diff;
+		}
+		n++;
+	}
+	fclose(f);
+	printf("Numeric check (%s) against %s: %d/%d episodes with same decisions | %d bit exact | max variable difference %g\n",
+		NUMERIC_NAME, path, same, n, exact, max_diff);
+	if(first >= 0)
+		printf("First decision mismatch: episode %d (seed %u)\n", first, pool->episodes[first].seed);
+	return (n == pool->n_episodes && same == n) ? 0 : -1;
+}
+
+/** ****************************************************************
+ * Batch runner entry point
+ *
+ * @param argc number of program arguments
+ * @param argv program arguments, -b episodes [-j threads] [-s seed] [-n max_ticks] [-f] [-o file] [-c reference]
+ * @brief function that run a batch of episodes and print aggregate results
+ * @return 0 when ok, -1 if error
+ * @note decay rates are drawn per episode within 50% of default decay of
+ * each need, episode i of seed s is reproducible alone
+***************************************************************** */
+int runner_main(int argc, char *argv[]){
+	runner_pool_t pool;
+	unsigned int seed = 1, s;
+	const char *csv = NULL, *ref = NULL;
+	uint64_t t0;
+	int i, k, started, r = 0;
+
+	memset(&pool, 0, sizeof(pool));
+	pool.max_ticks = RUNNER_MAX_TICKS;
+	pool.n_workers = sysconf(_SC_NPROCESSORS_ONLN);
+	if(argc > 2)
+		pool.n_episodes = atoi(argv[2]);
+	for(i=3; i<argc; i++){
+		if(strcmp(argv[i],"-j")==0 && i+1<argc)
+			pool.n_workers = atoi(argv[++i]);
+		else if(strcmp(argv[i],"-s")==0 && i+1<argc)
+			seed = strtoul(argv[++i], NULL, 10);
+		else if(strcmp(argv[i],"-n")==0 && i+1<argc)
+			pool.max_ticks = strtoul(argv[++i], NULL, 10);
+		else if(strcmp(argv[i],"-o")==0 && i+1<argc)
+			csv = argv[++i];
+		else if(strcmp(argv[i],"-c")==0 && i+1<argc)
+			ref = argv[++i];
+		else if(strcmp(argv[i],"-f")==0)
+			pool.fusion = 1;
+		else if(strcmp(argv[i],"-e")==0)
+			pool.rate = 1;
+	}
+	if(pool.n_episodes <= 0){
+		printf("ERROR: usage -b episodes [-j threads] [-s seed] [-n max_ticks] [-f] [-e] [-o file] [-c reference]\n");
+		return -1;
+	}
+	if(pool.n_workers <= 0)
+		pool.n_workers = 1;
+	if(pool.n_episodes > pool.n_workers*RUNNER_DEQUE_SIZE){
+		printf("ERROR: at most %d episodes on %d threads\n", pool.n_workers*RUNNER_DEQUE_SIZE, pool.n_workers);
+		return -1;
+	}
+
+	pool.episodes = calloc(pool.n_episodes, sizeof(episode_t));
+	pool.workers = calloc(pool.n_workers, sizeof(runner_worker_t));
+	if(pool.episodes == NULL || pool.workers == NULL){
+		printf("ERROR: could not allocate batch\n");
+		free(pool.episodes);
+		free(pool.workers);
+		return -1;
+	}
+	for(i=0; i<pool.n_episodes; i++){
+		episode_t *e = &pool.episodes[i];
+		s = seed*1000003u + i;
+		e->seed = s ? s : 1; // seed 0 is the default arena
+		for(k=0; k<NEED_COUNT; k++)
+			e->decay[k] = homeo_to_float(params_get()->decay[k])*(0.5f + (float)rand_r(&s)/RAND_MAX);
+	}
+	for(i=0; i<pool.n_workers; i++){
+		pool.workers[i].id = i;
+		pool.workers[i].pool = &pool;
+	}
+	// episodes are dealt round robin, workers then balance by stealing
+	for(i=0; i<pool.n_episodes; i++)
+		deque_push(&pool.workers[i % pool.n_workers].deque, i);
+
+	t0 = monotonic_ns();
+	for(started=0; started<pool.n_workers; started++){
+		if(pthread_create(&pool.workers[started].thread, NULL, &runner_thread, &pool.workers[started]) != 0){
+			printf("ERROR: could not create worker thread\n");
+			r = -1;
+			break; // started workers steal the episodes of the others
+		}
+	}
+	if(started == 0){
+		free(pool.episodes);
+		free(pool.workers);
+		return -1;
+	}
+	for(i=0; i<started; i++)
+		pthread_join(pool.workers[i].thread, NULL);
+
+	runner_print(&pool, (monotonic_ns() - t0)/1e9);
+	if(csv != NULL && runner_write_csv(&pool, csv) < 0)
+		r = -1;
+	if(ref != NULL && runner_compare(&pool, ref) < 0)
+		r = -1;
+	free(pool.episodes);
+	free(pool.workers);
+	return r;
+}
@@ -0,0 +1,55 @@
+/** ****************************************************************
+ * @file runner.h
+ * @brief Batch experiment runner on the simulated robot.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * Runs many independent model episodes on a pool of threads, each
+ * episode with its own simulated robot, arena and decay rates.
+ * Host build only.
+***************************************************************** */
+#ifndef RUNNER_H
+#define RUNNER_H
+
+#include <stdint.h>
+#include "needs.h"
+#include "rate.h"
+
+#define RUNNER_MAX_TICKS 20000 ///< default episode length limit (in ticks)
+#define RUNNER_DEQUE_SIZE 4096 ///< maximum number of episodes queued per worker
+
+/** ****************************************************************
+ * Episode result
+ *
+ * @brief parameters and outcome of one episode
+***************************************************************** */
+typedef struct {
+	unsigned int seed; ///< arena and parameters seed
+	float decay[NEED_COUNT]; ///< physiological variables decrease per tick
+	uint32_t ticks; ///< survival time (in ticks)
+	unsigned long switches; ///< number of behavioral group changes
+	unsigned long behaviour_ticks[NEED_COUNT]; ///< ticks spent in each behavioral group
+	int cause; ///< need whose variable reached 0 plus 1, 0 if still alive
+	unsigned long collisions; ///< physics steps blocked by a collision
+	uint32_t decisions; ///< digest of the behavioral group of each tick
+	float var[NEED_COUNT]; ///< physiological variables at the end
+	uint64_t tier_ns[RATE_TIERS]; ///< time spent in each loop rate tier (in ns), only with adaptive rate
+} episode_t;
+
+/** ****************************************************************
+ * Work-stealing deque
+ *
+ * @brief fixed size Chase-Lev deque of episode indexes
+ * @note owner pops at bottom, thieves steal at top, so the contended
+ * end is only touched by a CAS when a worker runs out of episodes
+***************************************************************** */
+typedef struct {
+	long top; ///< next index to steal
+	long bottom; ///< next free slot of owner
+	int buf[RUNNER_DEQUE_SIZE]; ///< episode indexes
+} runner_deque_t;
+
+int runner_main(int argc, char *argv[]);
+
+#endif
@@ -0,0 +1,107 @@
+/** ****************************************************************
+ * @file scheduler.c
+ * @brief Fixed-rate periodic scheduler for the model control loop.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * Deadline based scheduler using absolute wakeups on the monotonic
+ * clock, so the loop period does not drift with the work done in a tick.
+***************************************************************** */
+#include "scheduler.h"
+#include <stdio.h>
+
+/** ****************************************************************
+ * Init scheduler
+ *
+ * @param s scheduler to init
+ * @param period_us period of the loop (in us)
+ * @param clock robot device giving the clock, NULL for host monotonic clock
+ * @brief function that init scheduler, first deadline is one period from now
+ * @return 0 when ok, -1 if error
+***************************************************************** */
+int scheduler_init(scheduler_t *s, long period_us, hal_dev_t *clock){
+	if(period_us <= 0){
+		printf("ERROR: invalid scheduler period %ld us\n", period_us);
+		return -1;
+	}
+	s->clock = clock;
+	s->period_us = period_us;
+	s->last_ns = hal_now_ns(clock);
+	s->next_ns = s->last_ns + (uint64_t)period_us*1000ULL;
+	s->dt = (float)period_us;
+	s->ticks = 0;
+	s->overruns = 0;
+	s->skipped = 0;
+	s->max_lateness_ns = 0;
+	return 0;
+}
+
+/** ****************************************************************
+ * Wait for next tick
+ *
+ * @param s scheduler
+ * @brief function that wait for the next deadline and measure tick period
+ * @return 1 if the deadline was missed, 0 otherwise
+ * @note if more than one period is missed, missed periods are skipped
+ * instead of running a burst of late ticks
+***************************************************************** */
+int scheduler_wait(scheduler_t *s){
+	uint64_t period_ns = (uint64_t)s->period_us*1000ULL;
+	uint64_t now = hal_now_ns(s->clock);
+	int overrun = 0;
+
+	if(now > s->next_ns){
+		uint64_t late = now - s->next_ns;
+		overrun = 1;
+		s->overruns++;
+		if(late > s->max_lateness_ns)
+			s->max_lateness_ns = late;
+		if(late >= period_ns){
+			uint64_t missed = late / period_ns;
+			s->skipped += missed;
+			s->next_ns += missed*period_ns;
+		}
+	}
+	else
+		hal_sleep_until(s->clock, s->next_ns);
+
+	now = hal_now_ns(s->clock);
+	s->dt = (float)(now - s->last_ns) / 1000.0f;
+	s->last_ns = now;
+	s->next_ns += period_ns;
+	s->ticks++;
+	return overrun;
+}
+
+/** ****************************************************************
+ * Change period
+ *
+ * @param s scheduler, initialised
+ * @param period_us new period of the loop (in us)
+ * @brief function that change the period, next deadline is one new period after the last tick start
+ * @return 0 when ok, -1 if error
+ * @note a shorter period takes effect on the next wait, not one old period later
+***************************************************************** */
+int scheduler_set_period(scheduler_t *s, long period_us){
+	if(period_us <= 0){
+		printf("ERROR: invalid scheduler period %ld us\n", period_us);
+		return -1;
+	}
+	s->period_us = period_us;
+	s->next_ns = s->last_ns + (uint64_t)period_us*1000ULL;
+	return 0;
+}
+
+/** ****************************************************************
+ * Print scheduler stats
+ *
+ * @param s scheduler
+ * @brief function that print tick count and deadline overruns
+ * @return 0 when ok
+***************************************************************** */
+int scheduler_print_stats(const scheduler_t *s){
+	printf("Scheduler: %lu ticks at %ld us | %lu overruns | %lu skipped periods | worst lateness %.2f ms\n",
+		s->ticks, s->period_us, s->overruns, s->skipped, s->max_lateness_ns/1000000.0);
+	return 0;
+}
@@ -0,0 +1,53 @@
+/** ****************************************************************
+ * @file scheduler.h
+ * @brief Fixed-rate periodic scheduler for the model control loop.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * Deadline based scheduler using absolute wakeups on the monotonic
+ * clock, so the loop period does not drift with the work done in a tick.
+ * The clock is the one of a robot device (virtual time in simulation).
+***************************************************************** */
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+#include <time.h>
+#include "hal.h"
+
+/** ****************************************************************
+ * Periodic scheduler state
+ *
+ * @brief state of a deadline based periodic loop
+***************************************************************** */
+typedef struct {
+	hal_dev_t *clock; ///< robot device giving the clock, NULL for host monotonic clock
+	long period_us; ///< nominal period of the loop (in us)
+	uint64_t next_ns; ///< absolute deadline of the next tick (monotonic, in ns)
+	uint64_t last_ns; ///< time of the last tick start (monotonic, in ns)
+	float dt; ///< measured time between the two last tick starts (in us)
+	unsigned long ticks; ///< number of ticks done
+	unsigned long overruns; ///< number of ticks that missed their deadline
+	unsigned long skipped; ///< number of periods skipped after overruns
+	uint64_t max_lateness_ns; ///< worst lateness observed on a deadline (in ns)
+} scheduler_t;
+
+/** ****************************************************************
+ * Read monotonic clock
+ *
+ * @brief get monotonic time in ns
+ * @return monotonic time in ns
+***************************************************************** */
+static inline uint64_t monotonic_ns(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec*1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+int scheduler_init(scheduler_t *s, long period_us, hal_dev_t *clock);
+int scheduler_wait(scheduler_t *s);
+int scheduler_set_period(scheduler_t *s, long period_us);
+int scheduler_print_stats(const scheduler_t *s);
+
+#endif
@@ -0,0 +1,109 @@
+/** ****************************************************************
+ * @file snapshot.c
+ * @brief Lock-free snapshot of the model state for concurrent readers.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * Seqlock: the writer makes the counter odd, copies the snapshot and
+ * makes it even again. A reader copies the snapshot between two reads of
+ * an even and unchanged counter, and retries otherwise. Copies are done
+ * with relaxed atomic words, so a torn copy is only ever discarded, the
+ * acquisition seqlock uses the same copies for its frames.
+***************************************************************** */
+#include "snapshot.h"
+#include <stdio.h>
+#include <string.h>
+
+/** ****************************************************************
+ * Store words
+ *
+ * @param dst data guarded by a seqlock
+ * @param src new value
+ * @param size size of data (in bytes), a multiple of 4
+ * @brief function that copy data in a seqlock with relaxed atomic words (writer side)
+ * @return 0 when ok
+ * @note also used by the acquisition seqlock, data must be 4 bytes aligned
+***************************************************************** */
+int snapshot_store_words(void *dst, const void *src, size_t size){
+	uint32_t *d = (uint32_t*)dst;
+	const uint32_t *s = (const uint32_t*)src;
+	size_t i;
+	for(i=0; i<size/sizeof(uint32_t); i++)
+		__atomic_store_n(&d[i], s[i], __ATOMIC_RELAXED);
+	return 0;
+}
+
+/** ****************************************************************
+ * Load words
+ *
+ * @param dst copy of data
+ * @param src data guarded by a seqlock
+ * @param size size of data (in bytes), a multiple of 4
+ * @brief function that copy data out of a seqlock with relaxed atomic words (reader side)
+ * @return 0 when ok
+ * @note the copy may be torn, it is kept only if the counter did not change
+***************************************************************** */
+int snapshot_load_words(void *dst, const void *src, size_t size){
+	uint32_t *d = (uint32_t*)dst;
+	const uint32_t *s = (const uint32_t*)src;
+	size_t i;
+	for(i=0; i<size/sizeof(uint32_t); i++)
+		d[i] = __atomic_load_n(&s[i], __ATOMIC_RELAXED);
+	return 0;
+}
+
+/** ****************************************************************
+ * Init published snapshot
+ *
+ * @param p published snapshot
+ * @brief function that publish an empty snapshot, behaviour -1
+ * @return 0 when ok
+***************************************************************** */
+int snapshot_init(snapshot_pub_t *p){
+	memset(p, 0, sizeof(*p));
+	p->data.behaviour = -1;
+	return 0;
+}
+
+/** ****************************************************************
+ * Publish a snapshot
+ *
+ * @param p published snapshot
+ * @param s new snapshot
+ * @brief function that replace the published snapshot, never block
+ * @return 0 when ok
+ * @note single writer, the control thread
+***************************************************************** */
+int snapshot_publish(snapshot_pub_t *p, const snapshot_t *s){
+	uint32_t seq = p->seq;
+	__atomic_store_n(&p->seq, seq+1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE); // odd counter is visible before the data
+	snapshot_store_words(&p->data, s, sizeof(*s));
+	__atomic_store_n(&p->seq, seq+2, __ATOMIC_RELEASE);
+	return 0;
+}
+
+/** ****************************************************************
+ * Read the published snapshot
+ *
+ * @param p published snapshot
+ * @param s copy of the snapshot
+ * @brief function that copy a consistent published snapshot, without lock
+ * @return 0 when ok, -1 if the writer published during every one of SNAPSHOT_RETRIES reads
+***************************************************************** */
+int snapshot_read(const snapshot_pub_t *p, snapshot_t *s){
+	uint32_t seq;
+	int n;
+	for(n=0; n<SNAPSHOT_RETRIES; n++){
+		seq = __atomic_load_n(&p->seq, __ATOMIC_ACQUIRE);
+		if(seq & 1)
+			continue; // writer is copying
+		snapshot_load_words(s, &p->data, sizeof(*s));
+		__atomic_thread_fence(__ATOMIC_ACQUIRE); // data is read before the counter is checked
+		if(__atomic_load_n(&p->seq, __ATOMIC_RELAXED) == seq)
+			return 0;
+	}
+	printf("ERROR: could not read a consistent snapshot\n");
+	return -1;
+}
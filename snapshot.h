@@ -0,0 +1,58 @@
+/** ****************************************************************
+ * @file snapshot.h
+ * @brief Lock-free snapshot of the model state for concurrent readers.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * The control thread publishes the state of each tick in a seqlock, so
+ * other threads (fleet agent, leds, monitoring) read a consistent view
+ * without locks, and the control thread never waits for a slow reader.
+ * This header does not depend on libkhepera.
+***************************************************************** */
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "needs.h"
+
+#define SNAPSHOT_RETRIES 64 ///< reads of a snapshot before giving up on a writer that keeps publishing
+
+/** ****************************************************************
+ * Model state snapshot
+ *
+ * @brief plain copy of the model state at the end of a tick
+ * @note arrays of NEED_COUNT are in NEED_LIST order, only 32 and 64 bit fields so it is copied by words
+***************************************************************** */
+typedef struct {
+	uint64_t t_ns; ///< monotonic time of the tick sensors (in ns)
+	uint32_t tick; ///< tick number since model start
+	int32_t behaviour; ///< chosen behavioral group (need index), -1 before the first tick
+	float var[NEED_COUNT]; ///< physiological variables
+	float def[NEED_COUNT]; ///< deficits
+	float cue[NEED_COUNT]; ///< cues
+	float mot[NEED_COUNT]; ///< motivations
+	float left_speed; ///< commanded speed of left motor
+	float right_speed; ///< commanded speed of right motor
+	int32_t sensors[8]; ///< IR sensor values after clamp
+} snapshot_t;
+
+/** ****************************************************************
+ * Published snapshot
+ *
+ * @brief snapshot guarded by a sequence counter, odd while the writer copies it
+ * @note single writer, any number of readers
+***************************************************************** */
+typedef struct {
+	uint32_t seq; ///< sequence counter, incremented before and after each publication
+	snapshot_t data; ///< last published snapshot
+} __attribute__((aligned(64))) snapshot_pub_t;
+
+int snapshot_store_words(void *dst, const void *src, size_t size);
+int snapshot_load_words(void *dst, const void *src, size_t size);
+int snapshot_init(snapshot_pub_t *p);
+int snapshot_publish(snapshot_pub_t *p, const snapshot_t *s);
+int snapshot_read(const snapshot_pub_t *p, snapshot_t *s);
+
+#endif
@@ -0,0 +1,80 @@
+/** ****************************************************************
+ * @file stats.c
+ * @brief Incremental sliding window statistics of IR sensors.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * Min and max use monotonic queues of frame numbers, each frame enters
+ * and leaves a queue once. The window keeps the values the queues point
+ * to.
+***************************************************************** */
+#include "stats.h"
+#include <stdio.h>
+#include <string.h>
+
+/** ****************************************************************
+ * Init statistics
+ *
+ * @param s statistics
+ * @param alpha EWMA weight of a new frame in ]0,1], 1 for no smoothing
+ * @brief function that empty the window
+ * @return 0 when ok, -1 if alpha is invalid
+***************************************************************** */
+int stats_init(stats_t *s, float alpha){
+	if(!(alpha > 0.0f && alpha <= 1.0f)){
+		printf("ERROR: invalid EWMA weight %f\n", alpha);
+		return -1;
+	}
+	memset(s, 0, sizeof(*s));
+	s->alpha = alpha;
+	return 0;
+}
+
+/** ****************************************************************
+ * Push a frame in monotonic queue
+ *
+ * @param s statistics
+ * @param q queue of the channel
+ * @param ch channel
+ * @param v new value
+ * @param sign 1 for min queue, -1 for max queue
+ * @brief function that drop candidates beaten by the new frame and the one leaving window
+ * @return 0 when ok
+***************************************************************** */
+static int stats_queue_push(stats_t *s, stats_queue_t *q, int ch, int v, int sign){
+	uint32_t f = s->frames;
+	// oldest candidate leaves the window
+	if(q->tail != q->head && f - q->frame[q->head % STATS_WINDOW] >= STATS_WINDOW)
+		q->head++;
+	// candidates that are not better than new value will never be min (max) again
+	while(q->tail != q->head && sign*s->values[q->frame[(q->tail-1) % STATS_WINDOW] % STATS_WINDOW][ch] >= sign*v)
+		q->tail--;
+	q->frame[q->tail % STATS_WINDOW] = f;
+	q->tail++;
+	return 0;
+}
+
+/** ****************************************************************
+ * Push a frame
+ *
+ * @param s statistics
+ * @param v values of the new frame
+ * @brief function that add a frame in window and update statistics
+ * @return 0 when ok
+***************************************************************** */
+int stats_push(stats_t *s, const int v[STATS_CHANNELS]){
+	int *slot = s->values[s->frames % STATS_WINDOW];
+	int ch, total = 0;
+	for(ch=0; ch<STATS_CHANNELS; ch++)
+		total += v[ch];
+	s->ewma_total = s->frames ? s->ewma_total + s->alpha*(total - s->ewma_total) : total;
+	// slot is written before queues, they read values of the new frame
+	memcpy(slot, v, sizeof(int)*STATS_CHANNELS);
+	for(ch=0; ch<STATS_CHANNELS; ch++){
+		stats_queue_push(s, &s->min_q[ch], ch, v[ch], 1);
+		stats_queue_push(s, &s->max_q[ch], ch, v[ch], -1);
+	}
+	s->frames++;
+	return 0;
+}
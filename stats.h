@@ -0,0 +1,75 @@
+/** ****************************************************************
+ * @file stats.h
+ * @brief Incremental sliding window statistics of IR sensors.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * Statistics are updated once per frame, in amortized O(1) per channel,
+ * and read in O(1): window min and max of each channel, used by circular
+ * damage, and exponentially weighted moving average of the sum of
+ * channels, used by integrity cue.
+***************************************************************** */
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+
+#define STATS_CHANNELS 8 ///< number of channels (IR sensors)
+#define STATS_WINDOW 8 ///< number of frames in sliding window (power of 2)
+
+/** ****************************************************************
+ * Monotonic queue
+ *
+ * @brief frame numbers of window candidates for min or max of a channel
+***************************************************************** */
+typedef struct {
+	uint32_t frame[STATS_WINDOW]; ///< frame numbers, values are monotonic from head to tail
+	uint32_t head; ///< oldest candidate
+	uint32_t tail; ///< next free slot
+} stats_queue_t;
+
+/** ****************************************************************
+ * Sliding window statistics
+ *
+ * @brief statistics of the last STATS_WINDOW frames of each channel
+***************************************************************** */
+typedef struct {
+	uint32_t frames; ///< number of frames pushed
+	int values[STATS_WINDOW][STATS_CHANNELS]; ///< window of frames
+	float alpha; ///< EWMA weight of a new frame in ]0,1]
+	float ewma_total; ///< EWMA of the sum of channels
+	stats_queue_t min_q[STATS_CHANNELS]; ///< candidates for window min
+	stats_queue_t max_q[STATS_CHANNELS]; ///< candidates for window max
+} stats_t;
+
+int stats_init(stats_t *s, float alpha);
+int stats_push(stats_t *s, const int v[STATS_CHANNELS]);
+
+/** ****************************************************************
+ * Window min
+ *
+ * @param s statistics
+ * @param ch channel
+ * @brief function that give the min of a channel on the window
+ * @return min, 0 if no frame
+***************************************************************** */
+static inline int stats_min(const stats_t *s, int ch){
+	const stats_queue_t *q = &s->min_q[ch];
+	return s->frames ? s->values[q->frame[q->head % STATS_WINDOW] % STATS_WINDOW][ch] : 0;
+}
+
+/** ****************************************************************
+ * Window max
+ *
+ * @param s statistics
+ * @param ch channel
+ * @brief function that give the max of a channel on the window
+ * @return max, 0 if no frame
+***************************************************************** */
+static inline int stats_max(const stats_t *s, int ch){
+	const stats_queue_t *q = &s->max_q[ch];
+	return s->frames ? s->values[q->frame[q->head % STATS_WINDOW] % STATS_WINDOW][ch] : 0;
+}
+
+#endif
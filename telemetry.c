@@ -0,0 +1,424 @@
+/** ****************************************************************
+ * @file telemetry.c
+ * @brief Binary telemetry logger for the model.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * Fixed-size binary records are written in a preallocated in-memory ring
+ * by the model and flushed by a background writer to an append-only file.
+ * Console printing is an optional rate-limited view over the same ring.
+ * The writer can also stream records to a monitoring host over UDP:
+ * batches are sent straight from the ring with scatter-gather I/O and
+ * dropped when the socket is not ready, so the writer never blocks.
+***************************************************************** */
+#include "telemetry.h"
+#include "scheduler.h"
+#include "rt.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+/** ****************************************************************
+ * Telemetry state
+ *
+ * @brief memory ring shared by the model (producer) and the writer (consumer)
+***************************************************************** */
+static struct {
+	telemetry_record_t ring[TELEMETRY_RING]; ///< preallocated records
+	uint32_t head; ///< next record to reserve, written by the model
+	uint32_t tail; ///< next record to flush, written by the writer
+	telemetry_record_t last; ///< copy of the last flushed record
+	int has_last; ///< 1 when last is valid
+	FILE *file; ///< append-only telemetry file
+	pthread_t thread; ///< background writer
+	int running; ///< 1 while writer must run
+	long view_period_ms; ///< console view period (in ms), 0 if disabled
+	uint64_t last_view_ns; ///< time of the last console view
+	unsigned long dropped; ///< records dropped because ring was full
+	unsigned long written; ///< records written to file
+	int sock; ///< UDP socket connected to monitoring host, -1 if disabled
+	uint32_t udp_seq; ///< number of datagrams sent or dropped
+	unsigned long udp_sent; ///< datagrams sent
+	unsigned long udp_dropped; ///< datagrams dropped because socket was not ready
+} telemetry;
+
+/** ****************************************************************
+ * Open UDP stream
+ *
+ * @param target monitoring host as host:port
+ * @brief function that open a UDP socket connected to monitoring host
+ * @return 0 when ok, -1 if error
+***************************************************************** */
+static int telemetry_udp_open(const char *target){
+	struct addrinfo hints, *res;
+	char host[256];
+	const char *port = strrchr(target, ':');
+	size_t len;
+	if(port == NULL || port == target || (len = port - target) >= sizeof(host)){
+		printf("ERROR: invalid telemetry stream %s (expected host:port)\n", target);
+		return -1;
+	}
+	memcpy(host, target, len);
+	host[len] = '\0';
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_DGRAM;
+	if(getaddrinfo(host, port+1, &hints, &res) != 0){
+		printf("ERROR: could not resolve telemetry host %s\n", target);
+		return -1;
+	}
+	telemetry.sock = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+	if(telemetry.sock < 0 || connect(telemetry.sock, res->ai_addr, res->ai_addrlen) < 0){
+		printf("ERROR: could not open telemetry stream to %s\n", target);
+		if(telemetry.sock >= 0)
+			close(telemetry.sock);
+		telemetry.sock = -1;
+		freeaddrinfo(res);
+		return -1;
+	}
+	freeaddrinfo(res);
+	return 0;
+}
+
+/** ****************************************************************
+ * Send a datagram
+ *
+ * @param t first record to send
+ * @param n number of records, at most TELEMETRY_UDP_BATCH
+ * @brief function that send records of the ring in one datagram, without copy
+ * @return 0 when sent, -1 if dropped
+ * @note records wrapping around the end of the ring are sent as two slices
+***************************************************************** */
+static int telemetry_udp_send(uint32_t t, uint32_t n){
+	telemetry_datagram_t d;
+	struct iovec iov[3];
+	struct msghdr msg;
+	uint32_t idx = t & (TELEMETRY_RING-1);
+	uint32_t first = n < TELEMETRY_RING - idx ? n : TELEMETRY_RING - idx;
+	d.header.magic = TELEMETRY_MAGIC;
+	d.header.version = TELEMETRY_VERSION;
+	d.header.record_size = sizeof(telemetry_record_t);
+	d.seq = telemetry.udp_seq++;
+	d.dropped = telemetry.udp_dropped;
+	d.count = n;
+	iov[0].iov_base = &d;
+	iov[0].iov_len = sizeof(d);
+	iov[1].iov_base = &telemetry.ring[idx];
+	iov[1].iov_len = first*sizeof(telemetry_record_t);
+	iov[2].iov_base = &telemetry.ring[0];
+	iov[2].iov_len = (n-first)*sizeof(telemetry_record_t);
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = first < n ? 3 : 2;
+	if(sendmsg(telemetry.sock, &msg, MSG_DONTWAIT) < 0){
+		telemetry.udp_dropped++;
+		return -1;
+	}
+	telemetry.udp_sent++;
+	return 0;
+}
+
+/** ****************************************************************
+ * Console view
+ *
+ * @param h ring head read by the writer
+ * @param t ring tail read by the writer
+ * @brief function that print the newest record, at most once per view period
+ * @return 0 when ok
+***************************************************************** */
+static int telemetry_view(uint32_t h, uint32_t t){
+	const telemetry_record_t *r, *prev = NULL;
+	uint64_t now = monotonic_ns();
+	if(telemetry.view_period_ms <= 0 || h == t)
+		return 0;
+	if(now - telemetry.last_view_ns < (uint64_t)telemetry.view_period_ms*1000000ULL)
+		return 0;
+	telemetry.last_view_ns = now;
+	r = &telemetry.ring[(h-1) & (TELEMETRY_RING-1)];
+	if(h - t >= 2)
+		prev = &telemetry.ring[(h-2) & (TELEMETRY_RING-1)];
+	else if(telemetry.has_last)
+		prev = &telemetry.last;
+	print_vars(r);
+	print_clean_sensor(r, prev);
+	return 0;
+}
+
+/** ****************************************************************
+ * Flush ring
+ *
+ * @brief function that write all committed records to telemetry file and stream
+ * @return 0 when ok
+***************************************************************** */
+static int telemetry_flush(void){
+	uint32_t h = __atomic_load_n(&telemetry.head, __ATOMIC_ACQUIRE);
+	uint32_t t = telemetry.tail;
+	uint32_t idx, n;
+	if(h == t)
+		return 0;
+	telemetry_view(h, t);
+	telemetry.last = telemetry.ring[(h-1) & (TELEMETRY_RING-1)];
+	telemetry.has_last = 1;
+	for(idx=t; telemetry.sock >= 0 && idx != h; idx += n){
+		n = h - idx;
+		if(n > TELEMETRY_UDP_BATCH)
+			n = TELEMETRY_UDP_BATCH;
+		telemetry_udp_send(idx, n);
+	}
+	while(t != h){
+		idx = t & (TELEMETRY_RING-1);
+		n = h - t;
+		if(n > TELEMETRY_RING - idx)
+			n = TELEMETRY_RING - idx;
+		if(telemetry.file != NULL)
+			telemetry.written += fwrite(&telemetry.ring[idx], sizeof(telemetry_record_t), n, telemetry.file);
+		t += n;
+	}
+	if(telemetry.file != NULL)
+		fflush(telemetry.file);
+	__atomic_store_n(&telemetry.tail, t, __ATOMIC_RELEASE);
+	return 0;
+}
+
+/** ****************************************************************
+ * Telemetry writer
+ *
+ * @param args unused
+ * @brief thread that flush the ring every TELEMETRY_FLUSH
+***************************************************************** */
+static void* telemetry_writer(void *args){
+	scheduler_t sched;
+	rt_thread(RT_BACKGROUND);
+	scheduler_init(&sched, TELEMETRY_FLUSH, NULL);
+	while(__atomic_load_n(&telemetry.running, __ATOMIC_ACQUIRE)){
+		telemetry_flush();
+		scheduler_wait(&sched);
+	}
+	telemetry_flush();
+	return NULL;
+}
+
+/** ****************************************************************
+ * Check existing telemetry file
+ *
+ * @param path telemetry file
+ * @brief function that make sure new records are not appended to records of another layout
+ * @return 0 when ok, -1 if error
+ * @note a file of another version is renamed path.v<version>, a file that is not telemetry is refused
+***************************************************************** */
+static int telemetry_check_file(const char *path){
+	telemetry_header_t header;
+	char old[512];
+	FILE *f = fopen(path, "rb");
+	size_t n;
+	if(f == NULL)
+		return 0; // new file
+	n = fread(&header, 1, sizeof(header), f);
+	fclose(f);
+	if(n == 0)
+		return 0; // empty file, header is written
+	if(n != sizeof(header) || header.magic != TELEMETRY_MAGIC){
+		printf("ERROR: %s is not a telemetry file, not appending to it\n", path);
+		return -1;
+	}
+	if(header.version == TELEMETRY_VERSION && header.record_size == sizeof(telemetry_record_t))
+		return 0;
+	snprintf(old, sizeof(old), "%s.v%d", path, header.version);
+	if(rename(path, old) < 0){
+		printf("ERROR: could not rename telemetry file %s of version %d\n", path, header.version);
+		return -1;
+	}
+	printf("Telemetry: %s of version %d renamed %s\n", path, header.version, old);
+	return 0;
+}
+
+/** ****************************************************************
+ * Start telemetry
+ *
+ * @param path telemetry file, NULL for console view only
+ * @param udp monitoring host as host:port, NULL to disable streaming
+ * @param view_period_ms console view period (in ms), 0 to disable it
+ * @brief function that open telemetry file and stream and start background writer
+ * @return 0 when ok, -1 if error
+ * @note header is only written when the file is created, runs are appended to a file of the same version
+***************************************************************** */
+int telemetry_start(const char *path, const char *udp, long view_period_ms){
+	telemetry_header_t header;
+	telemetry.head = 0;
+	telemetry.tail = 0;
+	telemetry.has_last = 0;
+	telemetry.dropped = 0;
+	telemetry.written = 0;
+	telemetry.view_period_ms = view_period_ms;
+	telemetry.last_view_ns = 0;
+	telemetry.file = NULL;
+	telemetry.sock = -1;
+	telemetry.udp_seq = 0;
+	telemetry.udp_sent = 0;
+	telemetry.udp_dropped = 0;
+	if(udp != NULL && telemetry_udp_open(udp) < 0)
+		return -1;
+	if(path != NULL){
+		telemetry.file = telemetry_check_file(path) < 0 ? NULL : fopen(path, "ab");
+		if(telemetry.file == NULL){
+			printf("ERROR: could not open telemetry file %s\n", path);
+			if(telemetry.sock >= 0)
+				close(telemetry.sock);
+			telemetry.sock = -1;
+			return -1;
+		}
+		fseek(telemetry.file, 0, SEEK_END);
+		if(ftell(telemetry.file) == 0){
+			header.magic = TELEMETRY_MAGIC;
+			header.version = TELEMETRY_VERSION;
+			header.record_size = sizeof(telemetry_record_t);
+			fwrite(&header, sizeof(header), 1, telemetry.file);
+		}
+	}
+	telemetry.running = 1;
+	if(pthread_create(&telemetry.thread, NULL, &telemetry_writer, NULL) != 0){
+		printf("ERROR: could not create telemetry writer\n");
+		telemetry.running = 0;
+		if(telemetry.sock >= 0)
+			close(telemetry.sock);
+		telemetry.sock = -1;
+		return -1;
+	}
+	rt_set(telemetry.thread, RT_BACKGROUND); // by the creator, a SCHED_FIFO loop would keep the writer from running its own rt_thread()
+	return 0;
+}
+
+/** ****************************************************************
+ * Stop telemetry
+ *
+ * @brief function that flush remaining records and close telemetry file
+ * @return 0 when ok
+***************************************************************** */
+int telemetry_stop(void){
+	if(!telemetry.running)
+		return 0;
+	__atomic_store_n(&telemetry.running, 0, __ATOMIC_RELEASE);
+	pthread_join(telemetry.thread, NULL);
+	if(telemetry.file != NULL){
+		fclose(telemetry.file);
+		telemetry.file = NULL;
+	}
+	printf("Telemetry: %lu records written | %lu dropped\n", telemetry.written, telemetry.dropped);
+	if(telemetry.sock >= 0){
+		close(telemetry.sock);
+		telemetry.sock = -1;
+		printf("Telemetry stream: %lu datagrams sent | %lu dropped\n", telemetry.udp_sent, telemetry.udp_dropped);
+	}
+	return 0;
+}
+
+/** ****************************************************************
+ * Reserve a record
+ *
+ * @brief function that give the next free record of the ring (producer side)
+ * @return record to fill, NULL if telemetry is stopped or ring is full
+ * @note record is published by telemetry_commit(), never block
+***************************************************************** */
+telemetry_record_t *telemetry_reserve(void){
+	uint32_t h = telemetry.head;
+	if(!__atomic_load_n(&telemetry.running, __ATOMIC_ACQUIRE))
+		return NULL;
+	if(h - __atomic_load_n(&telemetry.tail, __ATOMIC_ACQUIRE) >= TELEMETRY_RING){
+		telemetry.dropped++;
+		return NULL;
+	}
+	return &telemetry.ring[h & (TELEMETRY_RING-1)];
+}
+
+/** ****************************************************************
+ * Commit a record
+ *
+ * @brief function that publish the record given by telemetry_reserve()
+ * @return 0 when ok
+***************************************************************** */
+int telemetry_commit(void){
+	__atomic_store_n(&telemetry.head, telemetry.head+1, __ATOMIC_RELEASE);
+	return 0;
+}
+
+/** ****************************************************************
+ * Print internal variables
+ * 
+ * @param r record to print
+ * @return 0 when ok
+ * @brief function that print internal variables 
+***************************************************************** */
+int print_vars(const telemetry_record_t *r){
+	int i;
+	printf("\033[H\033[2J"); /*clear output screen*/
+	printf("************************MODEL UPDATE**************************\n");
+	printf("**************************************************************\n");
+	for(i=0; i<NEED_COUNT; i++)
+		printf("%s%s = %.2f", i ? " | " : "", need_names[i], r->var[i]*100.0);
+	printf("\n**************************************************************\n");
+	for(i=0; i<NEED_COUNT; i++)
+		printf("%sdef = %.2f", i ? " | " : "", r->def[i]*100.0);
+	printf("\n**************************************************************\n");
+	for(i=0; i<NEED_COUNT; i++)
+		printf("%scue = %.2f", i ? " | " : "", r->cue[i]*100.0);
+	printf("\n**************************************************************\n");
+	for(i=0; i<NEED_COUNT; i++)
+		printf("%smot = %.2f", i ? " | " : "", r->mot[i]*100.0);
+	printf("\n**************************************************************\n");
+	printf("tick= %u | behaviour = %s | dt = %.2f ms\n", r->tick,
+		(r->behaviour >= 0 && r->behaviour < NEED_COUNT) ? need_names[r->behaviour] : "none", r->dt/1000.0);
+	printf("**************************************************************\n");
+	return 0;
+}
+
+/** ****************************************************************
+ * Clean sensors infos print
+ * 
+ * @param r record to print
+ * @param prev previous record, NULL if unknown
+ * @return 0 when ok
+ * @brief function that print previous  and actual sensor values 
+***************************************************************** */
+int print_clean_sensor(const telemetry_record_t *r, const telemetry_record_t *prev){
+	int i;
+	if(prev != NULL){
+		printf("************************HIST VALUES*************************\n");
+		printf("**************************************************************\n");
+		printf("\t\t");
+		for (i=0; i<8; i++)
+			printf(" %d ", prev->sensors[i]);
+		printf("\n**************************************************************\n");
+	}
+	printf("************************SENSOR VALUES*************************\n");
+	printf("**************************************************************\n");
+	printf("\t\t");
+	for (i=0; i<8; i++)
+		printf(" %d ", r->sensors[i]);
+	printf("\n**************************************************************\n");
+	if(prev != NULL){
+		printf("************************DIFF VALUES*************************\n");
+		printf("**************************************************************\n");
+		printf("\t\t");
+		for (i=0; i<8; i++)
+			printf(" %d ", r->sensors[i]-prev->sensors[i]);
+		printf("\n**************************************************************\n");
+	}
+	printf("*************************SPEED VALUES*************************\n");
+	printf("**************************************************************\n");
+	printf("\t");
+	for (i=0; i<8; i++)
+		printf(" %.2f ", r->speed[i]);
+	printf("\n**************************************************************\n");
+	printf("*********************CIRC SPEED VALUES************************\n");
+	printf("**************************************************************\n");
+	printf("\t\t");
+	for (i=0; i<7; i++)
+		printf(" %.2f ", r->circ_speed[i]);
+	printf("\n**************************************************************\n");
+	return 0;
+}
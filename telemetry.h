@@ -0,0 +1,95 @@
+/** ****************************************************************
+ * @file telemetry.h
+ * @brief Binary telemetry logger for the model.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * Fixed-size binary records are written in a preallocated in-memory ring
+ * by the model and flushed by a background writer to an append-only file,
+ * and optionally streamed as UDP datagrams to a monitoring host.
+ * This header only describes the file format and does not depend on
+ * libkhepera, so it is shared with the offline decoder.
+***************************************************************** */
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+#include "needs.h"
+
+#define TELEMETRY_MAGIC 0x5052544b ///< "KTRP" in little endian
+#define TELEMETRY_VERSION 5 ///< version of record layout
+#define TELEMETRY_RING 1024 ///< number of records in memory ring (power of 2)
+#define TELEMETRY_FLUSH 200000 ///< period of background writer (in us)
+#define TELEMETRY_FILE "telemetry.bin" ///< default telemetry file
+#define TELEMETRY_STAGES 7 ///< number of timed model stages in a record (probe order, PROBE_TICK first)
+#define TELEMETRY_TIERS 3 ///< number of loop rate tiers in a record (see rate.h)
+#define TELEMETRY_UDP_PAYLOAD 1472 ///< biggest datagram payload (Ethernet MTU without IP and UDP headers)
+
+/** ****************************************************************
+ * Telemetry file header
+ *
+ * @brief header written once at the beginning of a telemetry file
+***************************************************************** */
+typedef struct {
+	uint32_t magic; ///< TELEMETRY_MAGIC
+	uint16_t version; ///< TELEMETRY_VERSION
+	uint16_t record_size; ///< sizeof(telemetry_record_t)
+} telemetry_header_t;
+
+/** ****************************************************************
+ * Telemetry record
+ *
+ * @brief model state at the end of a tick
+ * @note arrays of NEED_COUNT are in NEED_LIST order
+ * @note tick 0 is the first frame read before the first tick, its behaviour is -1, as every tick of teleoperation
+***************************************************************** */
+typedef struct {
+	uint64_t t_ns; ///< monotonic time of the tick (in ns)
+	uint64_t us_t_ns; ///< monotonic time of the ultrasound reading (in ns), 0 if never read
+	uint32_t tick; ///< tick number since model start
+	int32_t behaviour; ///< chosen behavioral group (need index)
+	float var[NEED_COUNT]; ///< physiological variables
+	float def[NEED_COUNT]; ///< deficits
+	float cue[NEED_COUNT]; ///< cues
+	float mot[NEED_COUNT]; ///< motivations
+	float speed[8]; ///< speed based on IR sensor values
+	float circ_speed[7]; ///< circular speed based on IR sensor values
+	float left_speed; ///< commanded speed of left motor
+	float right_speed; ///< commanded speed of right motor
+	float dt; ///< measured tick period (in us)
+	int16_t sensors[8]; ///< IR sensor values after clamp
+	uint32_t stage_ns[TELEMETRY_STAGES]; ///< last duration of model stages (in ns, tick and telemetry of previous tick), 0 without probes
+	uint16_t ir[8]; ///< raw proximity values, before clamp
+	uint16_t ground[4]; ///< raw ground values
+	uint16_t us[5]; ///< last ultrasound values (in cm)
+	int16_t battery; ///< last battery charge (in %), -1 if not read yet
+	int16_t current; ///< last battery current (in mA)
+	int16_t tier; ///< loop rate tier of the tick (0 fast, 1 idle, 2 power saving)
+	uint32_t tier_ms[TELEMETRY_TIERS]; ///< time spent in each rate tier since model start (in ms)
+} telemetry_record_t;
+
+/** ****************************************************************
+ * Telemetry datagram header
+ *
+ * @brief header of a UDP datagram, followed by count records
+ * @note a gap in seq means datagrams were lost on the network or dropped by the robot
+***************************************************************** */
+typedef struct {
+	telemetry_header_t header; ///< same header as telemetry files
+	uint32_t seq; ///< datagram number since telemetry start
+	uint32_t dropped; ///< datagrams dropped by the robot since telemetry start
+	uint32_t count; ///< number of records in datagram
+} telemetry_datagram_t;
+
+/// number of records batched in a datagram
+#define TELEMETRY_UDP_BATCH ((TELEMETRY_UDP_PAYLOAD - sizeof(telemetry_datagram_t)) / sizeof(telemetry_record_t))
+
+int telemetry_start(const char *path, const char *udp, long view_period_ms);
+int telemetry_stop(void);
+telemetry_record_t *telemetry_reserve(void);
+int telemetry_commit(void);
+int print_vars(const telemetry_record_t *r);
+int print_clean_sensor(const telemetry_record_t *r, const telemetry_record_t *prev);
+
+#endif
@@ -0,0 +1,196 @@
+/** ****************************************************************
+ * @file teleop.c
+ * @brief Keyboard teleoperation with the sensing pipeline running.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * Each tick reads the pending keys without blocking, then runs the
+ * sensing stages of a model tick (sensors, damage detectors, variables)
+ * and records it with behaviour -1. The last key holds: z, q, s, d drive,
+ * e stops, a (or SIGINT) quits. Piped commands work too, the end of the
+ * input quits.
+***************************************************************** */
+#include "teleop.h"
+#include "telemetry.h"
+#include "probe.h"
+#include "rt.h"
+#include "bus.h"
+#include "leds.h"
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <termios.h>
+#include <unistd.h>
+
+/** ****************************************************************
+ * Teleop state
+ *
+ * @brief held command and terminal settings
+***************************************************************** */
+static struct {
+	float left; ///< held speed of left motor in [-1.0,1.0]
+	float right; ///< held speed of right motor in [-1.0,1.0]
+	unsigned long keys; ///< commands received
+	struct termios saved; ///< terminal settings before raw mode
+	int raw; ///< 1 when the terminal is in raw mode
+} teleop;
+
+static volatile sig_atomic_t teleop_quit_requested = 0; ///< set by SIGINT and SIGTERM
+
+/** ****************************************************************
+ * Quit handler
+ *
+ * @param sig signal number
+ * @brief handler that request the end of teleoperation, the terminal is restored by the loop
+***************************************************************** */
+static void teleop_signal(int sig){
+	teleop_quit_requested = 1;
+}
+
+/** ****************************************************************
+ * Set terminal in raw mode
+ *
+ * @brief function that make keys readable one by one without echo, signals are kept
+ * @return 0 when ok, -1 if stdin is not a terminal
+***************************************************************** */
+static int teleop_raw(void){
+	struct termios t;
+	if(tcgetattr(STDIN_FILENO, &teleop.saved) < 0)
+		return -1;
+	t = teleop.saved;
+	t.c_lflag &= ~(ICANON | ECHO);
+	t.c_cc[VMIN] = 1;
+	t.c_cc[VTIME] = 0;
+	if(tcsetattr(STDIN_FILENO, TCSANOW, &t) < 0)
+		return -1;
+	teleop.raw = 1;
+	return 0;
+}
+
+/** ****************************************************************
+ * Read pending keys
+ *
+ * @param m model context
+ * @brief function that apply the keys typed since the last tick, never waits
+ * @return 1 when teleoperation must end, 0 otherwise
+***************************************************************** */
+static int teleop_keys(model_t *m){
+	struct pollfd p;
+	char keys[16];
+	ssize_t n, i;
+	p.fd = STDIN_FILENO;
+	p.events = POLLIN;
+	if(poll(&p, 1, 0) <= 0)
+		return 0;
+	n = read(STDIN_FILENO, keys, sizeof(keys));
+	if(n <= 0)
+		return 1; // end of input
+	for(i=0; i<n; i++){
+		switch(keys[i]){
+			case 'z':
+				printf("Move forward\n");
+				teleop.left = 1.0, teleop.right = 1.0;
+			break;
+			case 'q':
+				printf("Move left\n");
+				teleop.left = -1.0, teleop.right = 1.0;
+			break;
+			case 's':
+				printf("Move backward\n");
+				teleop.left = -1.0, teleop.right = -1.0;
+			break;
+			case 'd':
+				printf("Move right\n");
+				teleop.left = 1.0, teleop.right = -1.0;
+			break;
+			case 'e':
+				printf("Stop\n");
+				teleop.left = 0.0, teleop.right = 0.0;
+			break;
+			case 'a':
+				printf("Exit program\n");
+				return 1;
+			case ' ': case '\n': case '\r': case '\t':
+				continue; // separators of piped commands
+			default:
+				printf("Error : Unknown command %c\n", keys[i]);
+				continue;
+		}
+		teleop.keys++;
+	}
+	return 0;
+}
+
+/** ****************************************************************
+ * Teleop tick
+ *
+ * @param m model context
+ * @brief function that run the sensing stages of a model tick and send the held command
+ * @return 0 when ok
+ * @note same stages and probes as model_tick(), behaviour selection is replaced by the driver
+***************************************************************** */
+static int teleop_tick(model_t *m){
+	m->tick++;
+	PROBE_BEGIN(PROBE_TICK);
+	update_vars(m, 1);
+	PROBE_BEGIN(PROBE_MOVE);
+	move(m, teleop.left, teleop.right);
+	motors_commit(&m->motors); // held command is merged, the bus is written on changes only
+	PROBE_END(PROBE_MOVE);
+	PROBE_BEGIN(PROBE_TELEMETRY);
+	record_tick(m, -1);
+	publish_tick(m, -1);
+	PROBE_END(PROBE_TELEMETRY);
+	get_sensors_history(m);
+	PROBE_END(PROBE_TICK);
+	return 0;
+}
+
+/** ****************************************************************
+ * Run teleoperation
+ *
+ * @param m model context, options parsed by model_options()
+ * @brief function that drive the robot from the keyboard, sensing and telemetry run at tick_period
+ * @return 0 when ok, -1 if error
+ * @note the loop does not end when a variable reaches 0, the driver quits
+***************************************************************** */
+int teleop_main(model_t *m){
+	struct sigaction sa;
+	probe_install_signal(); // SIGUSR1 dumps probes
+	if(m->rt && (rt_start() < 0 || bus_thread_class(RT_ACQUISITION) < 0 || leds_thread_class(RT_BACKGROUND) < 0))
+		return -1;
+	if(telemetry_start(telemetry_path, telemetry_udp, telemetry_view) < 0)
+		return -1;
+	m->telemetry = 1;
+	if(scheduler_init(&m->sched, m->tick_period, m->robot) < 0 || stats_init(&m->ir_stats, m->cue_alpha) < 0
+		|| acquisition_start(&m->acquisition, m->robot, m->acquisition_period, m->fusion ? ACQ_US_DIV : 0) < 0){
+		telemetry_stop();
+		return -1;
+	}
+	sa.sa_handler = teleop_signal;
+	sigemptyset(&sa.sa_mask);
+	sa.sa_flags = SA_RESTART;
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+	teleop_raw(); // piped input is read as is
+	printf("z,q,s,d for robot control, e for stop, a for exit\n");
+	model_prime(m);
+	rt_loop_start();
+	while(!teleop_quit_requested && !teleop_keys(m)){
+		teleop_tick(m);
+		probe_poll();
+		scheduler_wait(&m->sched);
+		m->tick_dt = m->sched.dt;
+	}
+	if(teleop.raw)
+		tcsetattr(STDIN_FILENO, TCSANOW, &teleop.saved);
+	acquisition_stop(&m->acquisition);
+	stop_moving(m);
+	telemetry_stop();
+	printf("Teleop: %lu commands in %u ticks\n", teleop.keys, m->tick);
+	scheduler_print_stats(&m->sched);
+	rt_print_stats();
+	probe_dump();
+	return 0;
+}
@@ -0,0 +1,20 @@
+/** ****************************************************************
+ * @file teleop.h
+ * @brief Keyboard teleoperation with the sensing pipeline running.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * The robot is driven by hand while acquisition, damage detection and
+ * telemetry run at the model tick rate, so damage and scratch datasets
+ * are recorded at full sensor rate. The terminal is in raw mode and
+ * stdin is polled once per tick, the loop never waits for a key.
+***************************************************************** */
+#ifndef TELEOP_H
+#define TELEOP_H
+
+#include "model.h"
+
+int teleop_main(model_t *m);
+
+#endif
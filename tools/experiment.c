@@ -0,0 +1,190 @@
+/** ****************************************************************
+ * @file experiment.c
+ * @brief Pack telemetry files in an experiment file and query it.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * Host tool on top of the columnar experiment format (experiment.h).
+ * pack splits telemetry files of robots and episodes in runs and writes
+ * them as column chunks, query decodes only the chunks of the selected
+ * runs and time range and only the selected columns, and prints CSV.
+***************************************************************** */
+#include "../experiment.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** ****************************************************************
+ * Pack telemetry files
+ *
+ * @param out experiment file
+ * @param files telemetry files
+ * @param n number of telemetry files
+ * @brief function that write every run of the telemetry files in an experiment file
+ * @return 0 when ok, -1 if error
+ * @note a new run is detected when tick number goes back, as telemetry_decode does
+***************************************************************** */
+static int pack(const char *out, char *files[], int n){
+	experiment_writer_t w;
+	telemetry_header_t header;
+	telemetry_record_t r;
+	char name[EXPERIMENT_NAME];
+	uint32_t last_tick = 0;
+	FILE *f;
+	int i, run, ret = 0;
+
+	if(experiment_create(&w, out) < 0)
+		return -1;
+	for(i=0; i<n && ret == 0; i++){
+		f = fopen(files[i], "rb");
+		if(f == NULL || fread(&header, sizeof(header), 1, f) != 1 || header.magic != TELEMETRY_MAGIC
+			|| header.version != TELEMETRY_VERSION || header.record_size != sizeof(r)){
+			printf("ERROR: %s is not a telemetry file of version %d\n", files[i], TELEMETRY_VERSION);
+			if(f)
+				fclose(f);
+			ret = -1;
+			break;
+		}
+		run = -1;
+		while(ret == 0 && fread(&r, sizeof(r), 1, f) == 1){
+			if(run < 0 || r.tick <= last_tick){
+				snprintf(name, sizeof(name), "%s:%d", files[i], ++run);
+				ret = experiment_begin_run(&w, name);
+			}
+			last_tick = r.tick;
+			if(ret == 0)
+				ret = experiment_append(&w, &r);
+		}
+		fclose(f);
+	}
+	if(experiment_finish(&w) < 0 || ret < 0)
+		return -1;
+	fprintf(stderr, "%u runs | %u chunks | %u columns | %.1f MB of records packed in %.1f MB of chunks\n",
+		w.runs, w.chunks, w.columns, w.bytes_in/1e6, w.pos/1e6);
+	return 0;
+}
+
+/** ****************************************************************
+ * Print file index
+ *
+ * @param e experiment file
+ * @brief function that print runs and columns with their compressed size
+ * @return 0 when ok
+***************************************************************** */
+static int info(const experiment_t *e){
+	const uint32_t *off;
+	uint64_t size;
+	uint32_t c, k;
+	printf("run,name,rows,chunks,duration_ms\n");
+	for(k=0; k<e->runs; k++)
+		printf("%u,%s,%llu,%u,%.1f\n", k, e->run[k].name, (unsigned long long)e->run[k].rows, e->run[k].chunks,
+			(e->run[k].last_ns - e->run[k].first_ns)/1e6);
+	printf("column,name,type,bytes\n");
+	for(c=0; c<e->columns; c++){
+		size = 0;
+		for(k=0; k<e->chunks; k++){
+			off = &e->offsets[(size_t)k*(e->columns+1)];
+			size += off[c+1] - off[c];
+		}
+		printf("%u,%s,%d,%llu\n", c, e->column[c].name, e->column[c].type, (unsigned long long)size);
+	}
+	return 0;
+}
+
+/** ****************************************************************
+ * Query columns
+ *
+ * @param e experiment file
+ * @param run run to print, -1 for every run
+ * @param from_ms begin of time range since run start (in ms)
+ * @param to_ms end of time range since run start, included (in ms), negative for run end
+ * @param names column names
+ * @param n number of columns
+ * @brief function that print as CSV the rows of the selected runs and time range
+ * @return 0 when ok, -1 if error
+ * @note chunks out of the range are skipped from the index, only t_ns and the selected columns are decoded
+***************************************************************** */
+static int query(const experiment_t *e, int run, double from_ms, double to_ms, char *names[], int n){
+	static double val[EXPERIMENT_COLUMNS][EXPERIMENT_CHUNK];
+	static int64_t t_ns[EXPERIMENT_CHUNK];
+	const experiment_run_t *r;
+	int col[EXPERIMENT_COLUMNS], t_col, i;
+	uint64_t from_ns, to_ns;
+	uint32_t k;
+	long rows, j;
+
+	if(n > EXPERIMENT_COLUMNS){
+		printf("ERROR: more than %d columns queried\n", EXPERIMENT_COLUMNS);
+		return -1;
+	}
+	for(i=0; i<n; i++)
+		if((col[i] = experiment_find(e, names[i])) < 0){
+			printf("ERROR: no column %s in experiment\n", names[i]);
+			return -1;
+		}
+	t_col = experiment_find(e, "t_ns");
+	printf("run,t_ms");
+	for(i=0; i<n; i++)
+		printf(",%s", names[i]);
+	printf("\n");
+	for(k=0; k<e->chunks; k++){
+		if(run >= 0 && e->chunk[k].run != (uint32_t)run)
+			continue;
+		r = &e->run[e->chunk[k].run];
+		from_ns = r->first_ns + (uint64_t)(from_ms*1e6);
+		to_ns = to_ms < 0 ? r->last_ns : r->first_ns + (uint64_t)(to_ms*1e6);
+		if(!experiment_overlaps(e, k, from_ns, to_ns))
+			continue;
+		if((rows = experiment_decode_int(e, k, t_col, t_ns)) < 0)
+			return -1;
+		for(i=0; i<n; i++)
+			if(experiment_decode(e, k, col[i], val[i]) < 0)
+				return -1;
+		for(j=0; j<rows; j++){
+			if((uint64_t)t_ns[j] < from_ns || (uint64_t)t_ns[j] > to_ns)
+				continue;
+			printf("%u,%.3f", e->chunk[k].run, ((uint64_t)t_ns[j] - r->first_ns)/1e6);
+			for(i=0; i<n; i++)
+				printf(e->column[col[i]].type == EXPERIMENT_F32 ? ",%.9g" : ",%.17g", val[i][j]); // shortest exact print of floats, integers up to 2^53
+			printf("\n");
+		}
+	}
+	return 0;
+}
+
+/** ****************************************************************
+ * Main function
+ * @brief pack telemetry files or query an experiment file
+ *
+ * @param argc number of arguments
+ * @param argv pack out.exp telemetry.bin... | info file.exp | query file.exp [-r run] [-t from_ms:to_ms] column...
+ * @return 0 when ok, -1 if error
+***************************************************************** */
+int main(int argc, char *argv[]){
+	experiment_t e;
+	double from_ms = 0, to_ms = -1;
+	int run = -1, i = 3, r;
+
+	if(argc >= 4 && strcmp(argv[1], "pack") == 0)
+		return pack(argv[2], argv + 3, argc - 3);
+	if(argc < 3 || (strcmp(argv[1], "info") != 0 && strcmp(argv[1], "query") != 0)){
+		printf("usage: %s pack out.exp telemetry.bin... | info file.exp | query file.exp [-r run] [-t from_ms:to_ms] column...\n", argv[0]);
+		return -1;
+	}
+	if(experiment_open(&e, argv[2]) < 0)
+		return -1;
+	if(strcmp(argv[1], "info") == 0)
+		r = info(&e);
+	else{
+		for(; i+1<argc && argv[i][0] == '-'; i+=2){
+			if(strcmp(argv[i], "-r") == 0)
+				run = atoi(argv[i+1]);
+			else if(strcmp(argv[i], "-t") == 0 && sscanf(argv[i+1], "%lf:%lf", &from_ms, &to_ms) < 1)
+				break;
+		}
+		r = query(&e, run, from_ms, to_ms, argv + i, argc - i);
+	}
+	experiment_close(&e);
+	return r;
+}
@@ -0,0 +1,448 @@
+/** ****************************************************************
+ * @file fleet.c
+ * @brief Coordinator of TRP experiments on a fleet of robots.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * Host tool that connect to the agent of every robot (./model -g),
+ * estimate the offset of each robot clock from the round trip of clock
+ * probes (best of FLEET_PROBES, refreshed every FLEET_RESYNC), push the
+ * same model options to all robots and start them at the same instant.
+ * Events of all robots are printed as CSV on the coordinator clock, in ms
+ * since start. All connections are served by a single epoll loop.
+***************************************************************** */
+#include "../fleet.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+#define FLEET_MAX 64 ///< biggest fleet
+#define FLEET_PROBES 8 ///< clock probes per synchronisation round
+#define FLEET_RESYNC 5000000000ULL ///< period of clock synchronisation while running (in ns)
+#define FLEET_DELAY 2000 ///< default delay between synchronisation and start (in ms)
+
+/** ****************************************************************
+ * Robot states
+ *
+ * @brief steps of an experiment on a robot
+***************************************************************** */
+enum {
+	ROBOT_CONNECTING = 0, ///< TCP connection in progress
+	ROBOT_SYNCING, ///< first clock synchronisation round
+	ROBOT_READY, ///< synchronised and configured, waiting for the others
+	ROBOT_RUNNING, ///< model started
+	ROBOT_DONE ///< model stopped or robot lost
+};
+
+/** ****************************************************************
+ * Robot connection
+ *
+ * @brief state of the connection to a robot agent
+***************************************************************** */
+typedef struct {
+	const char *name; ///< robot address as given on command line
+	int sock; ///< connection to agent
+	int state; ///< ROBOT_* step
+	unsigned char buf[4*sizeof(fleet_msg_t)]; ///< bytes received, not yet parsed
+	size_t len; ///< number of bytes in buf
+	int probes; ///< clock probes answered in actual round
+	uint64_t round_rtt; ///< best round trip of actual round (in ns)
+	int64_t round_offset; ///< robot clock offset of best round trip
+	uint64_t rtt; ///< round trip of offset in use (in ns)
+	int64_t offset; ///< robot clock minus coordinator clock (in ns)
+	uint64_t next_sync_ns; ///< time of next synchronisation round
+} robot_t;
+
+static const char *event_names[] = {
+	"", "hello", "sync", "config", "start", "started", "switch", "damage", "death", "status"
+}; ///< message names for CSV
+
+static robot_t robots[FLEET_MAX]; ///< fleet
+static int robot_count = 0; ///< number of robots in fleet
+static uint64_t start_ns = 0; ///< start time on coordinator clock, 0 before start
+
+/** ****************************************************************
+ * Read monotonic clock
+ *
+ * @brief get monotonic time in ns
+ * @return monotonic time in ns
+***************************************************************** */
+static uint64_t now_ns(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec*1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/** ****************************************************************
+ * Send a message
+ *
+ * @param r robot
+ * @param msg message to send, msg->size bytes
+ * @brief function that send a message to a robot agent
+ * @return 0 when ok, -1 if error
+ * @note messages are small and rare, a send that does not fit in socket buffer loses the robot
+***************************************************************** */
+static int robot_send(robot_t *r, const fleet_msg_t *msg){
+	if(send(r->sock, msg, msg->size, MSG_NOSIGNAL) != msg->size){
+		fprintf(stderr, "ERROR: could not send to %s\n", r->name);
+		return -1;
+	}
+	return 0;
+}
+
+/** ****************************************************************
+ * Send a clock probe
+ *
+ * @param r robot
+ * @brief function that send a clock probe stamped with coordinator clock
+ * @return 0 when ok, -1 if error
+***************************************************************** */
+static int robot_probe(robot_t *r){
+	fleet_msg_t msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.type = FLEET_SYNC;
+	msg.size = sizeof(msg);
+	msg.t_ns = now_ns();
+	return robot_send(r, &msg);
+}
+
+/** ****************************************************************
+ * Close a robot
+ *
+ * @param ep epoll instance
+ * @param r robot
+ * @brief function that close the connection to a robot agent
+ * @return 0 when ok
+***************************************************************** */
+static int robot_close(int ep, robot_t *r){
+	if(r->state == ROBOT_DONE)
+		return 0;
+	epoll_ctl(ep, EPOLL_CTL_DEL, r->sock, NULL);
+	close(r->sock);
+	r->state = ROBOT_DONE;
+	return 0;
+}
+
+/** ****************************************************************
+ * Print an event
+ *
+ * @param id robot number
+ * @param msg event of robot
+ * @brief function that print an event as a CSV line, on coordinator clock
+ * @return 0 when ok
+***************************************************************** */
+static int print_event(int id, const fleet_msg_t *msg){
+	int64_t t = (int64_t)(msg->t_ns - robots[id].offset - start_ns);
+	printf("%d,%s,%.3f,%u,%s,%d,%d,%.3f\n", id, robots[id].name, t/1000000.0, msg->tick,
+		event_names[msg->type], msg->a, msg->b, robots[id].rtt/2000000.0);
+	fflush(stdout);
+	return 0;
+}
+
+/** ****************************************************************
+ * Start fleet
+ *
+ * @param delay_ms delay between now and start (in ms)
+ * @brief function that start all robots when all of them are ready
+ * @return 1 when fleet is started, 0 otherwise
+***************************************************************** */
+static int fleet_start(long delay_ms){
+	fleet_msg_t msg;
+	int i;
+	for(i=0; i<robot_count; i++)
+		if(robots[i].state != ROBOT_READY && robots[i].state != ROBOT_DONE)
+			return 0;
+	start_ns = now_ns() + (uint64_t)delay_ms*1000000ULL;
+	memset(&msg, 0, sizeof(msg));
+	msg.type = FLEET_START;
+	msg.size = sizeof(msg);
+	msg.t_ns = start_ns;
+	for(i=0; i<robot_count; i++){
+		if(robots[i].state != ROBOT_READY)
+			continue;
+		msg.t2_ns = start_ns + robots[i].offset;
+		if(robot_send(&robots[i], &msg) == 0){
+			robots[i].state = ROBOT_RUNNING;
+			robots[i].next_sync_ns = start_ns + FLEET_RESYNC;
+		}
+		fprintf(stderr, "robot %d: %s offset %.3f ms | rtt %.3f ms\n", i, robots[i].name,
+			robots[i].offset/1000000.0, robots[i].rtt/1000000.0);
+	}
+	return 1;
+}
+
+/** ****************************************************************
+ * Handle a message
+ *
+ * @param ep epoll instance
+ * @param id robot number
+ * @param msg message of robot
+ * @param args model options to push
+ * @param args_size size of model options (in bytes)
+ * @brief function that update robot state with a message of its agent
+ * @return 0 when ok, -1 if robot is lost
+***************************************************************** */
+static int robot_message(int ep, int id, const fleet_msg_t *msg, const char *args, size_t args_size){
+	robot_t *r = &robots[id];
+	fleet_msg_t config;
+	uint64_t t3 = now_ns(), rtt;
+	int64_t offset;
+	switch(msg->type){
+		case FLEET_HELLO:
+			if(msg->a != FLEET_VERSION){
+				fprintf(stderr, "ERROR: %s speaks fleet protocol %d\n", r->name, msg->a);
+				return -1;
+			}
+			memset(&config, 0, sizeof(config));
+			config.type = FLEET_CONFIG;
+			config.size = sizeof(config) + args_size;
+			if(send(r->sock, &config, sizeof(config), MSG_NOSIGNAL|MSG_MORE) != sizeof(config)
+				|| send(r->sock, args, args_size, MSG_NOSIGNAL) != (ssize_t)args_size){
+				fprintf(stderr, "ERROR: could not configure %s\n", r->name);
+				return -1;
+			}
+			r->probes = 0;
+			r->round_rtt = UINT64_MAX;
+			return robot_probe(r);
+		case FLEET_SYNC:
+			// NTP estimate, robot time spent between receive and send is not part of the round trip
+			rtt = (t3 - msg->t_ns) - (msg->t3_ns - msg->t2_ns);
+			offset = ((int64_t)(msg->t2_ns - msg->t_ns) + (int64_t)(msg->t3_ns - t3)) / 2;
+			if(rtt < r->round_rtt){
+				r->round_rtt = rtt;
+				r->round_offset = offset;
+			}
+			if(++r->probes < FLEET_PROBES)
+				return robot_probe(r);
+			r->rtt = r->round_rtt;
+			r->offset = r->round_offset;
+			if(r->state == ROBOT_SYNCING)
+				r->state = ROBOT_READY;
+			r->next_sync_ns = t3 + FLEET_RESYNC;
+			return 0;
+		case FLEET_STARTED:
+		case FLEET_SWITCH:
+		case FLEET_DAMAGE:
+		case FLEET_STATUS:
+			print_event(id, msg);
+			return 0;
+		case FLEET_DEATH:
+			print_event(id, msg);
+			robot_close(ep, r);
+			return 0;
+		default:
+			return 0;
+	}
+}
+
+/** ****************************************************************
+ * Read a robot
+ *
+ * @param ep epoll instance
+ * @param id robot number
+ * @param args model options to push
+ * @param args_size size of model options (in bytes)
+ * @brief function that receive bytes of a robot and handle complete messages
+ * @return 0 when ok, -1 if robot is lost
+***************************************************************** */
+static int robot_read(int ep, int id, const char *args, size_t args_size){
+	robot_t *r = &robots[id];
+	fleet_msg_t msg;
+	ssize_t n;
+	n = recv(r->sock, r->buf + r->len, sizeof(r->buf) - r->len, 0);
+	if(n < 0 && (errno == EAGAIN || errno == EINTR))
+		return 0;
+	if(n <= 0){
+		fprintf(stderr, "ERROR: lost %s\n", r->name);
+		return -1;
+	}
+	r->len += n;
+	while(r->len >= sizeof(msg) && r->state != ROBOT_DONE){
+		memcpy(&msg, r->buf, sizeof(msg));
+		if(msg.size != sizeof(msg)){
+			fprintf(stderr, "ERROR: invalid message of %s\n", r->name);
+			return -1;
+		}
+		r->len -= sizeof(msg);
+		memmove(r->buf, r->buf + sizeof(msg), r->len);
+		if(robot_message(ep, id, &msg, args, args_size) < 0)
+			return -1;
+	}
+	return 0;
+}
+
+/** ****************************************************************
+ * Connect a robot
+ *
+ * @param ep epoll instance
+ * @param id robot number
+ * @param port default agent port
+ * @brief function that start a non blocking connection to a robot agent
+ * @return 0 when ok, -1 if error
+***************************************************************** */
+static int robot_connect(int ep, int id, int port){
+	robot_t *r = &robots[id];
+	struct addrinfo hints, *res;
+	struct epoll_event ev;
+	char host[256], service[16];
+	const char *sep = strrchr(r->name, ':');
+	size_t len = sep != NULL ? (size_t)(sep - r->name) : strlen(r->name);
+	if(len >= sizeof(host))
+		return -1;
+	memcpy(host, r->name, len);
+	host[len] = '\0';
+	snprintf(service, sizeof(service), "%s", sep != NULL ? sep+1 : "");
+	if(sep == NULL)
+		snprintf(service, sizeof(service), "%d", port);
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+	if(getaddrinfo(host, service, &hints, &res) != 0){
+		fprintf(stderr, "ERROR: could not resolve %s\n", r->name);
+		return -1;
+	}
+	r->sock = socket(res->ai_family, res->ai_socktype | SOCK_NONBLOCK, res->ai_protocol);
+	if(r->sock < 0 || (connect(r->sock, res->ai_addr, res->ai_addrlen) < 0 && errno != EINPROGRESS)){
+		fprintf(stderr, "ERROR: could not connect to %s\n", r->name);
+		freeaddrinfo(res);
+		if(r->sock >= 0)
+			close(r->sock);
+		return -1;
+	}
+	freeaddrinfo(res);
+	r->state = ROBOT_CONNECTING;
+	ev.events = EPOLLIN | EPOLLOUT;
+	ev.data.u32 = id;
+	return epoll_ctl(ep, EPOLL_CTL_ADD, r->sock, &ev);
+}
+
+/** ****************************************************************
+ * Connection done
+ *
+ * @param ep epoll instance
+ * @param id robot number
+ * @brief function that check a non blocking connection and wait for agent greeting
+ * @return 0 when ok, -1 if connection failed
+***************************************************************** */
+static int robot_connected(int ep, int id){
+	robot_t *r = &robots[id];
+	struct epoll_event ev;
+	int err = 0, one = 1;
+	socklen_t len = sizeof(err);
+	if(getsockopt(r->sock, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err != 0){
+		fprintf(stderr, "ERROR: could not connect to %s (%s)\n", r->name, strerror(err));
+		return -1;
+	}
+	setsockopt(r->sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	r->state = ROBOT_SYNCING;
+	ev.events = EPOLLIN;
+	ev.data.u32 = id;
+	return epoll_ctl(ep, EPOLL_CTL_MOD, r->sock, &ev);
+}
+
+/** ****************************************************************
+ * Main function
+ * @brief run a TRP experiment on a fleet of robots
+ *
+ * @param argc number of arguments
+ * @param argv [-p port] [-d delay_ms] robot[:port]... [-- model options]
+ * @return 0 when ok, -1 if error
+ * @note events are printed on standard output as CSV, sort on t_ms to merge robot timelines
+***************************************************************** */
+int main(int argc, char *argv[]){
+	struct epoll_event events[FLEET_MAX];
+	char args[FLEET_ARGS];
+	size_t args_size = 0, len;
+	long delay_ms = FLEET_DELAY;
+	int port = FLEET_PORT, ep, i, n, id, alive, timeout;
+	uint64_t now, next;
+
+	for(i=1; i<argc; i++){
+		if(strcmp(argv[i],"-p")==0 && i+1<argc)
+			port = atoi(argv[++i]);
+		else if(strcmp(argv[i],"-d")==0 && i+1<argc)
+			delay_ms = atol(argv[++i]);
+		else if(strcmp(argv[i],"--")==0)
+			break;
+		else if(robot_count < FLEET_MAX)
+			robots[robot_count++].name = argv[i];
+	}
+	for(i++; i<argc; i++){
+		len = strlen(argv[i]) + 1;
+		if(args_size + len > FLEET_ARGS){
+			fprintf(stderr, "ERROR: model options longer than %d bytes\n", FLEET_ARGS);
+			return -1;
+		}
+		memcpy(args + args_size, argv[i], len);
+		args_size += len;
+	}
+	if(robot_count == 0){
+		printf("usage: %s [-p port] [-d delay_ms] robot[:port]... [-- model options]\n", argv[0]);
+		return -1;
+	}
+	ep = epoll_create1(0);
+	if(ep < 0){
+		fprintf(stderr, "ERROR: could not create epoll instance\n");
+		return -1;
+	}
+	for(i=0; i<robot_count; i++)
+		if(robot_connect(ep, i, port) < 0)
+			robots[i].state = ROBOT_DONE;
+
+	printf("robot,name,t_ms,tick,event,a,b,accuracy_ms\n");
+	for(;;){
+		now = now_ns();
+		next = now + 1000000000ULL;
+		alive = 0;
+		for(i=0; i<robot_count; i++){
+			if(robots[i].state == ROBOT_DONE)
+				continue;
+			alive++;
+			if(robots[i].state != ROBOT_RUNNING)
+				continue;
+			if(robots[i].next_sync_ns <= now){
+				robots[i].probes = 0;
+				robots[i].round_rtt = UINT64_MAX;
+				robots[i].next_sync_ns = UINT64_MAX; // set again when round is done
+				if(robot_probe(&robots[i]) < 0)
+					robot_close(ep, &robots[i]);
+			}
+			else if(robots[i].next_sync_ns < next)
+				next = robots[i].next_sync_ns;
+		}
+		if(alive == 0)
+			break;
+		timeout = (int)((next - now) / 1000000ULL) + 1;
+		n = epoll_wait(ep, events, FLEET_MAX, timeout);
+		if(n < 0 && errno != EINTR){
+			fprintf(stderr, "ERROR: epoll wait failed\n");
+			break;
+		}
+		for(i=0; i<n; i++){
+			id = events[i].data.u32;
+			if(robots[id].state == ROBOT_DONE)
+				continue;
+			if(robots[id].state == ROBOT_CONNECTING){
+				if(robot_connected(ep, id) < 0)
+					robot_close(ep, &robots[id]);
+				continue;
+			}
+			if(robot_read(ep, id, args, args_size) < 0)
+				robot_close(ep, &robots[id]);
+		}
+		if(start_ns == 0)
+			fleet_start(delay_ms);
+	}
+	close(ep);
+	return 0;
+}
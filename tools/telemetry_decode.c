@@ -0,0 +1,204 @@
+/** ****************************************************************
+ * @file telemetry_decode.c
+ * @brief Offline decoder for model telemetry files.
+ * @author Louis L'Haridon
+ * @version 0.1
+ * @date 14 octobre 2026
+ *
+ * Host tool that convert a binary telemetry file written by the model
+ * into CSV, one line per record. It can also listen to telemetry streamed
+ * over UDP by a fleet of robots, then the run column is the robot number.
+***************************************************************** */
+#include "../telemetry.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#define MAX_ROBOTS 64 ///< biggest fleet listened by the decoder
+
+/** ****************************************************************
+ * Print CSV header
+ *
+ * @brief function that print column names
+ * @return 0 when ok
+***************************************************************** */
+static int print_header(void){
+	static const char *prefix[4] = {"var", "def", "cue", "mot"};
+	int i, k;
+	printf("run,t_ns,tick,behaviour");
+	for(k=0; k<4; k++)
+		for(i=0; i<NEED_COUNT; i++)
+			printf(",%s_%s", prefix[k], need_names[i]);
+	for(i=0; i<8; i++)
+		printf(",sensor_%d", i);
+	for(i=0; i<8; i++)
+		printf(",speed_%d", i);
+	for(i=0; i<7; i++)
+		printf(",circ_speed_%d", i);
+	printf(",left_speed,right_speed,dt");
+	for(i=0; i<TELEMETRY_STAGES; i++)
+		printf(",stage_ns_%d", i);
+	for(i=0; i<8; i++)
+		printf(",ir_%d", i);
+	for(i=0; i<4; i++)
+		printf(",ground_%d", i);
+	for(i=0; i<5; i++)
+		printf(",us_%d", i);
+	printf(",us_t_ns,battery,current,tier");
+	for(i=0; i<TELEMETRY_TIERS; i++)
+		printf(",tier_ms_%d", i);
+	printf("\n");
+	return 0;
+}
+
+/** ****************************************************************
+ * Print a record
+ *
+ * @param run run number in file
+ * @param r record to print
+ * @brief function that print a record as a CSV line
+ * @return 0 when ok
+***************************************************************** */
+static int print_record(int run, const telemetry_record_t *r){
+	int i;
+	printf("%d,%llu,%u,%d", run, (unsigned long long)r->t_ns, r->tick, r->behaviour);
+	for(i=0; i<NEED_COUNT; i++)
+		printf(",%f", r->var[i]);
+	for(i=0; i<NEED_COUNT; i++)
+		printf(",%f", r->def[i]);
+	for(i=0; i<NEED_COUNT; i++)
+		printf(",%f", r->cue[i]);
+	for(i=0; i<NEED_COUNT; i++)
+		printf(",%f", r->mot[i]);
+	for(i=0; i<8; i++)
+		printf(",%d", r->sensors[i]);
+	for(i=0; i<8; i++)
+		printf(",%f", r->speed[i]);
+	for(i=0; i<7; i++)
+		printf(",%f", r->circ_speed[i]);
+	printf(",%f,%f,%f", r->left_speed, r->right_speed, r->dt);
+	for(i=0; i<TELEMETRY_STAGES; i++)
+		printf(",%u", r->stage_ns[i]);
+	for(i=0; i<8; i++)
+		printf(",%u", r->ir[i]);
+	for(i=0; i<4; i++)
+		printf(",%u", r->ground[i]);
+	for(i=0; i<5; i++)
+		printf(",%u", r->us[i]);
+	printf(",%llu,%d,%d,%d", (unsigned long long)r->us_t_ns, r->battery, r->current, r->tier);
+	for(i=0; i<TELEMETRY_TIERS; i++)
+		printf(",%u", r->tier_ms[i]);
+	printf("\n");
+	return 0;
+}
+
+/** ****************************************************************
+ * Listen to a fleet
+ *
+ * @param port UDP port to listen
+ * @brief function that print records of datagrams sent by robots, until killed
+ * @return -1 if error
+ * @note lost datagrams are reported on standard error, from sequence gaps
+***************************************************************** */
+static int listen_fleet(int port){
+	static unsigned char buf[65536];
+	struct sockaddr_in addr, robots[MAX_ROBOTS];
+	uint32_t next_seq[MAX_ROBOTS];
+	socklen_t len;
+	telemetry_datagram_t d;
+	telemetry_record_t r;
+	int sock, n = 0, id;
+	ssize_t size;
+	uint32_t i;
+
+	sock = socket(AF_INET, SOCK_DGRAM, 0);
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons(port);
+	if(sock < 0 || bind(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0){
+		printf("ERROR: could not listen on UDP port %d\n", port);
+		return -1;
+	}
+	print_header();
+	fflush(stdout);
+	for(;;){
+		len = sizeof(addr);
+		size = recvfrom(sock, buf, sizeof(buf), 0, (struct sockaddr*)&addr, &len);
+		if(size < (ssize_t)sizeof(d))
+			continue;
+		memcpy(&d, buf, sizeof(d));
+		if(d.header.magic != TELEMETRY_MAGIC || d.header.version != TELEMETRY_VERSION
+			|| d.header.record_size != sizeof(r) || size != (ssize_t)(sizeof(d) + d.count*sizeof(r)))
+			continue;
+		for(id=0; id<n; id++)
+			if(robots[id].sin_addr.s_addr == addr.sin_addr.s_addr && robots[id].sin_port == addr.sin_port)
+				break;
+		if(id == n){
+			if(n == MAX_ROBOTS)
+				continue;
+			robots[n++] = addr;
+			fprintf(stderr, "robot %d: %s:%d\n", id, inet_ntoa(addr.sin_addr), ntohs(addr.sin_port));
+		}
+		else if(d.seq != next_seq[id])
+			fprintf(stderr, "robot %d: %d datagrams lost (%u dropped by robot)\n", id, (int)(d.seq - next_seq[id]), d.dropped);
+		next_seq[id] = d.seq + 1;
+		for(i=0; i<d.count; i++){
+			memcpy(&r, buf + sizeof(d) + i*sizeof(r), sizeof(r));
+			print_record(id, &r);
+		}
+		fflush(stdout);
+	}
+	return -1;
+}
+
+/** ****************************************************************
+ * Main function
+ * @brief decode a telemetry file to CSV on standard output
+ *
+ * @param argc number of arguments
+ * @param argv telemetry file name, or -u port to listen to robots
+ * @return 0 when ok, -1 if error
+ * @note a new run is detected when tick number goes back
+***************************************************************** */
+int main(int argc, char *argv[]){
+	telemetry_header_t header;
+	telemetry_record_t r;
+	FILE *f;
+	int run = -1;
+	uint32_t last_tick = 0;
+
+	if(argc < 2){
+		printf("usage: %s telemetry.bin | -u port\n", argv[0]);
+		return -1;
+	}
+	if(strcmp(argv[1],"-u")==0)
+		return argc < 3 ? -1 : listen_fleet(atoi(argv[2]));
+	f = fopen(argv[1], "rb");
+	if(f == NULL){
+		printf("ERROR: could not open %s\n", argv[1]);
+		return -1;
+	}
+	if(fread(&header, sizeof(header), 1, f) != 1 || header.magic != TELEMETRY_MAGIC){
+		printf("ERROR: %s is not a telemetry file\n", argv[1]);
+		fclose(f);
+		return -1;
+	}
+	if(header.version != TELEMETRY_VERSION || header.record_size != sizeof(telemetry_record_t)){
+		printf("ERROR: unsupported telemetry version %d (record size %d)\n", header.version, header.record_size);
+		fclose(f);
+		return -1;
+	}
+	print_header();
+	while(fread(&r, sizeof(r), 1, f) == 1){
+		if(run < 0 || r.tick <= last_tick)
+			run++;
+		last_tick = r.tick;
+		print_record(run, &r);
+	}
+	fclose(f);
+	return 0;
+}